@@ -0,0 +1,141 @@
+#include "big_expr.h"
+#include "mpn.h"
+
+#include <algorithm>
+
+// columns [i, end) of r += sum of the first M operands; M is a constant so the inner loop unrolls
+template <size_t M>
+int64_t big_expr_evaluator::sum_columns(uint32_t* r, size_t i, size_t end, const plain_operand* ops, int64_t carry)
+{
+    const uint32_t* limbs[M];
+    int64_t mask[M];
+    for (size_t k = 0; k < M; ++k)
+    {
+        limbs[k] = ops[k].limbs;
+        mask[k] = ops[k].mask;
+    }
+    for (; i < end; ++i)
+    {
+        int64_t s = carry + r[i];
+        for (size_t k = 0; k < M; ++k)
+        {
+            // (x ^ mask) - mask is x or -x
+            s += (static_cast<int64_t>(limbs[k][i]) ^ mask[k]) - mask[k];
+        }
+        r[i] = static_cast<uint32_t>(s);
+        carry = s >> mpn::LIMB_BITS;
+    }
+    return carry;
+}
+
+void big_expr_evaluator::add_plain(uint32_t* r, size_t len, const plain_operand* ops, size_t m)
+{
+    static int64_t (* const sum[MAX_FUSED + 1])(uint32_t*, size_t, size_t, const plain_operand*, int64_t) = {
+            nullptr, sum_columns<1>, sum_columns<2>, sum_columns<3>, sum_columns<4>,
+            sum_columns<5>, sum_columns<6>, sum_columns<7>, sum_columns<8>};
+    static_assert(MAX_FUSED == 8, "sum table must cover MAX_FUSED");
+
+    int64_t carry = 0;
+    size_t i = 0;
+    for (; m > 0; --m)
+    {
+        // columns where exactly the first m operands are present
+        carry = sum[m](r, i, ops[m - 1].size, ops, carry);
+        i = std::max(i, ops[m - 1].size);
+    }
+    for (; carry && i < len; ++i)
+    {
+        int64_t s = carry + r[i];
+        r[i] = static_cast<uint32_t>(s);
+        carry = s >> mpn::LIMB_BITS;
+    }
+}
+
+bool big_expr_evaluator::is_zero_term(big_term const& t)
+{
+    return t.a->is_zero() || (t.b && t.b->is_zero());
+}
+
+big_integer big_expr_evaluator::evaluate(const big_term* terms, size_t n)
+{
+    // every term fits in len - 1 limbs; the spare limb keeps the sum of up to 2^31 terms
+    // within len-limb two's complement, where all the accumulation happens
+    size_t len = 0;
+    bool has_products = false;
+    bool has_plain = false;
+    for (size_t k = 0; k < n; ++k)
+    {
+        if (is_zero_term(terms[k]))
+            continue;
+        size_t bound = terms[k].a->size();
+        if (terms[k].b)
+        {
+            bound += terms[k].b->size();
+            has_products = true;
+        }
+        else
+            has_plain = true;
+        len = std::max(len, bound);
+    }
+    ++len;
+
+    // the result buffer is the only allocation
+    limb_vector acc;
+    acc.resize_uninitialized(len);
+    uint32_t* r = acc.mutable_data();
+    std::fill(r, r + len, 0);
+
+    // products are accumulated row by row, carries and borrows wrap modulo B^len
+    for (size_t k = 0; k < n && has_products; ++k)
+    {
+        big_term const& t = terms[k];
+        if (!t.b || is_zero_term(t))
+            continue;
+
+        big_integer const* x = t.a;
+        big_integer const* y = t.b;
+        if (x->size() < y->size())
+            std::swap(x, y);
+        const uint32_t* xd = x->number.cbegin();
+        const uint32_t* yd = y->number.cbegin();
+        size_t xn = x->size();
+        bool subtract = (t.negative != x->sign) != y->sign;
+
+        if (subtract)
+            mpn::submul(r, len, xd, xn, yd, y->size());
+        else
+            mpn::addmul(r, len, xd, xn, yd, y->size());
+    }
+
+    // plain terms are summed in signed carry passes over r, up to MAX_FUSED operands per pass
+    size_t k = 0;
+    while (has_plain && k < n)
+    {
+        plain_operand batch[MAX_FUSED];
+        size_t m = 0;
+        for (; k < n && m < MAX_FUSED; ++k)
+        {
+            big_term const& t = terms[k];
+            if (t.b || is_zero_term(t))
+                continue;
+            plain_operand op = {t.a->number.cbegin(), t.a->size(), (t.negative != t.a->sign) ? -1 : 0};
+            // keep the batch sorted by size, largest first, so the active operands form a prefix
+            size_t pos = m++;
+            for (; pos > 0 && batch[pos - 1].size < op.size; --pos)
+                batch[pos] = batch[pos - 1];
+            batch[pos] = op;
+        }
+        if (m == 0)
+            break;
+        add_plain(r, len, batch, m);
+    }
+    // a negative sum is left in two's complement, which normalize() translates back
+    bool negative = r[len - 1] >> (mpn::LIMB_BITS - 1);
+
+    big_integer result;
+    result.number.swap(acc);
+    result.sign = negative;
+    result.is_two_complemented = negative;
+    result.normalize();
+    return result;
+}
@@ -0,0 +1,272 @@
+#ifndef BIG_EXPR_H
+#define BIG_EXPR_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+
+// Opt-in expression templates for sums of big_integer terms and products of two operands:
+//
+//     big_integer r = lazy(a) * b + lazy(c) * d - e;
+//
+// Nothing is computed until the expression is converted to big_integer. Then all terms are summed
+// into one buffer: products are accumulated row by row, plain operands in a single signed carry pass.
+// Expressions hold pointers to their operands, so evaluate them within the same full-expression.
+
+// one signed term of an expression: *a, or *a * *b when b is not null
+struct big_term
+{
+    const big_integer* a;
+    const big_integer* b;
+    bool negative;
+};
+
+class big_expr_evaluator
+{
+    // plain operands summed in one carry pass
+    static const size_t MAX_FUSED = 8;
+
+    struct plain_operand
+    {
+        const uint32_t* limbs;
+        size_t size;
+        int64_t mask; // -1 when the operand is subtracted
+    };
+
+    static bool is_zero_term(big_term const& t);
+    template <size_t M>
+    static int64_t sum_columns(uint32_t* r, size_t i, size_t end, const plain_operand* ops, int64_t carry);
+    static void add_plain(uint32_t* r, size_t len, const plain_operand* ops, size_t m);
+
+public:
+    static big_integer evaluate(const big_term* terms, size_t n);
+};
+
+template <size_t N>
+class big_expr
+{
+public:
+    big_term terms[N];
+
+    big_expr() = default;
+
+    template <size_t L, size_t R>
+    big_expr(big_expr<L> const& lhs, big_expr<R> const& rhs, bool negate_rhs)
+    {
+        static_assert(L + R == N, "expression size mismatch");
+        for (size_t i = 0; i < L; ++i)
+            terms[i] = lhs.terms[i];
+        for (size_t i = 0; i < R; ++i)
+        {
+            terms[L + i] = rhs.terms[i];
+            terms[L + i].negative ^= negate_rhs;
+        }
+    }
+
+    big_expr operator-() const
+    {
+        big_expr result(*this);
+        for (size_t i = 0; i < N; ++i)
+            result.terms[i].negative = !result.terms[i].negative;
+        return result;
+    }
+
+    operator big_integer() const
+    {
+        return big_expr_evaluator::evaluate(terms, N);
+    }
+};
+
+// a deferred operand; the entry point into expressions
+class big_ref
+{
+    const big_integer* value;
+
+public:
+    explicit big_ref(big_integer const& a) : value(&a) {}
+
+    big_expr<1> term(const big_integer* b = nullptr, bool negative = false) const
+    {
+        big_expr<1> result;
+        result.terms[0].a = value;
+        result.terms[0].b = b;
+        result.terms[0].negative = negative;
+        return result;
+    }
+
+    big_expr<1> operator-() const
+    {
+        return term(nullptr, true);
+    }
+
+    operator big_integer() const
+    {
+        return *value;
+    }
+
+    big_integer const& get() const
+    {
+        return *value;
+    }
+};
+
+inline big_ref lazy(big_integer const& a)
+{
+    return big_ref(a);
+}
+
+namespace big_expr_detail
+{
+    inline big_expr<1> to_expr(big_ref const& a)
+    {
+        return a.term();
+    }
+
+    inline big_expr<1> to_expr(big_integer const& a)
+    {
+        return big_ref(a).term();
+    }
+
+    template <size_t N>
+    big_expr<N> const& to_expr(big_expr<N> const& a)
+    {
+        return a;
+    }
+}
+
+// products of two operands
+
+inline big_expr<1> operator*(big_ref const& a, big_ref const& b)
+{
+    return a.term(&b.get());
+}
+
+inline big_expr<1> operator*(big_ref const& a, big_integer const& b)
+{
+    return a.term(&b);
+}
+
+inline big_expr<1> operator*(big_integer const& a, big_ref const& b)
+{
+    return b.term(&a);
+}
+
+// sums and differences, at least one side deferred
+
+template <size_t L, size_t R>
+big_expr<L + R> operator+(big_expr<L> const& a, big_expr<R> const& b)
+{
+    return big_expr<L + R>(a, b, false);
+}
+
+template <size_t L, size_t R>
+big_expr<L + R> operator-(big_expr<L> const& a, big_expr<R> const& b)
+{
+    return big_expr<L + R>(a, b, true);
+}
+
+template <size_t N>
+big_expr<N + 1> operator+(big_expr<N> const& a, big_integer const& b)
+{
+    return a + big_expr_detail::to_expr(b);
+}
+
+template <size_t N>
+big_expr<N + 1> operator-(big_expr<N> const& a, big_integer const& b)
+{
+    return a - big_expr_detail::to_expr(b);
+}
+
+template <size_t N>
+big_expr<N + 1> operator+(big_integer const& a, big_expr<N> const& b)
+{
+    return big_expr_detail::to_expr(a) + b;
+}
+
+template <size_t N>
+big_expr<N + 1> operator-(big_integer const& a, big_expr<N> const& b)
+{
+    return big_expr_detail::to_expr(a) - b;
+}
+
+template <size_t N>
+big_expr<N + 1> operator+(big_expr<N> const& a, big_ref const& b)
+{
+    return a + big_expr_detail::to_expr(b);
+}
+
+template <size_t N>
+big_expr<N + 1> operator-(big_expr<N> const& a, big_ref const& b)
+{
+    return a - big_expr_detail::to_expr(b);
+}
+
+template <size_t N>
+big_expr<N + 1> operator+(big_ref const& a, big_expr<N> const& b)
+{
+    return big_expr_detail::to_expr(a) + b;
+}
+
+template <size_t N>
+big_expr<N + 1> operator-(big_ref const& a, big_expr<N> const& b)
+{
+    return big_expr_detail::to_expr(a) - b;
+}
+
+inline big_expr<2> operator+(big_ref const& a, big_ref const& b)
+{
+    return big_expr_detail::to_expr(a) + big_expr_detail::to_expr(b);
+}
+
+inline big_expr<2> operator-(big_ref const& a, big_ref const& b)
+{
+    return big_expr_detail::to_expr(a) - big_expr_detail::to_expr(b);
+}
+
+inline big_expr<2> operator+(big_ref const& a, big_integer const& b)
+{
+    return big_expr_detail::to_expr(a) + big_expr_detail::to_expr(b);
+}
+
+inline big_expr<2> operator-(big_ref const& a, big_integer const& b)
+{
+    return big_expr_detail::to_expr(a) - big_expr_detail::to_expr(b);
+}
+
+inline big_expr<2> operator+(big_integer const& a, big_ref const& b)
+{
+    return big_expr_detail::to_expr(a) + big_expr_detail::to_expr(b);
+}
+
+inline big_expr<2> operator-(big_integer const& a, big_ref const& b)
+{
+    return big_expr_detail::to_expr(a) - big_expr_detail::to_expr(b);
+}
+
+// machine-word operands end the expression: it is evaluated and the word is added in place
+
+template <size_t N, typename T>
+enable_if_integral<T, big_integer> operator+(big_expr<N> const& a, T b)
+{
+    return big_integer(a) += b;
+}
+
+template <size_t N, typename T>
+enable_if_integral<T, big_integer> operator-(big_expr<N> const& a, T b)
+{
+    return big_integer(a) -= b;
+}
+
+template <size_t N, typename T>
+enable_if_integral<T, big_integer> operator+(T a, big_expr<N> const& b)
+{
+    return big_integer(b) += a;
+}
+
+template <size_t N, typename T>
+enable_if_integral<T, big_integer> operator-(T a, big_expr<N> const& b)
+{
+    return big_integer(-b) += a;
+}
+
+#endif // BIG_EXPR_H
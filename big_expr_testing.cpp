@@ -0,0 +1,86 @@
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "big_expr.h"
+
+namespace
+{
+    big_integer rand_big(size_t size)
+    {
+        big_integer result = rand();
+
+        for (size_t i = 0; i != size; ++i)
+        {
+            result *= RAND_MAX;
+            result += rand();
+        }
+
+        return rand() % 2 ? -result : result;
+    }
+}
+
+TEST(expr, small)
+{
+    big_integer a = 3, b = 4, c = 5, d = 6, e = 7;
+    big_integer r = lazy(a) * b + lazy(c) * d - e;
+    EXPECT_EQ(r, 35);
+
+    r = lazy(a) - b;
+    EXPECT_EQ(r, -1);
+    r = e - lazy(a) * d;
+    EXPECT_EQ(r, -11);
+    r = -(lazy(a) * b) + c;
+    EXPECT_EQ(r, -7);
+    r = -lazy(a) + b + c;
+    EXPECT_EQ(r, 6);
+}
+
+TEST(expr, zero_and_sign)
+{
+    big_integer a("123456789012345678901234567890"), zero;
+    big_integer r = lazy(a) * a - lazy(a) * a;
+    EXPECT_EQ(r, 0);
+    EXPECT_EQ(to_string(r), "0");
+
+    r = lazy(a) * zero + zero - a;
+    EXPECT_EQ(r, -a);
+    r = lazy(-a) * a + a;
+    EXPECT_EQ(r, -a * a + a);
+    r = lazy(-a) * -a - a;
+    EXPECT_EQ(r, a * a - a);
+}
+
+TEST(expr, carries)
+{
+    big_integer max("340282366920938463463374607431768211455"); // 2^128 - 1
+    big_integer r = lazy(max) + max + max + 1;
+    EXPECT_EQ(r, max * 3 + 1);
+    r = lazy(max) * max + lazy(max) * max + max;
+    EXPECT_EQ(r, max * max * 2 + max);
+    r = 1 - lazy(max) * max;
+    EXPECT_EQ(r, 1 - max * max);
+    r = lazy(max) * max - 1;
+    EXPECT_EQ(r, max * max - 1);
+}
+
+TEST(expr, not_fused_falls_back)
+{
+    big_integer a = 10, b = 20, c = 30;
+    big_integer r = (lazy(a) + b) * c;
+    EXPECT_EQ(r, 900);
+}
+
+TEST(expr, matches_eager_randomized)
+{
+    for (size_t itn = 0; itn != 1000; ++itn)
+    {
+        big_integer a = rand_big(rand() % 20), b = rand_big(rand() % 20), c = rand_big(rand() % 20);
+        big_integer d = rand_big(rand() % 20), e = rand_big(rand() % 40);
+
+        big_integer lazy_result = lazy(a) * b + lazy(c) * d - e;
+        ASSERT_EQ(lazy_result, a * b + c * d - e);
+
+        lazy_result = e - lazy(a) * b - lazy(c) * d + a - c;
+        ASSERT_EQ(lazy_result, e - a * b - c * d + a - c);
+    }
+}
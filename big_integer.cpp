@@ -1,9 +1,12 @@
 #include "big_integer.h"
+#include "mpn.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
-typedef optimized_vector vector;
+typedef limb_vector vector;
 
 big_integer::big_integer() : sign(false),
                              number(1, 0),
@@ -18,26 +21,29 @@ big_integer::big_integer(big_integer const& other) : sign(other.sign),
     this->normalize();
 }
 
-big_integer::big_integer(int a) : sign(a < 0),
-                                  number(),
-                                  is_two_complemented(false)
+#ifdef __SIZEOF_INT128__
+big_integer::big_integer(int128_t a) : big_integer(a < 0 ? ~static_cast<uint128_t>(a) + 1 : static_cast<uint128_t>(a))
 {
-    number.push_back(a >= 0 ? static_cast<uint32_t>(a) : ~static_cast<uint32_t>(a) + 1);
-    first_non_zero_index = 0;
+    sign = (a < 0);
 }
 
-
-big_integer::big_integer(optimized_vector const& number, bool sign, bool two_complemented) :
-                                                sign(sign), number(number), is_two_complemented(two_complemented)
+big_integer::big_integer(uint128_t a) : sign(false),
+                                        number(),
+                                        is_two_complemented(false)
 {
-    this->normalize();
+    number.resize_uninitialized(4);
+    uint32_t* d = number.mutable_data();
+    for (size_t i = 0; i < 4; ++i, a >>= LOG_BASE)
+        d[i] = static_cast<uint32_t>(a);
+    normalize();
 }
+#endif
 
 
-big_integer::big_integer(uint32_t x): sign(false), number({x}), first_non_zero_index(x ? 0 : SIZE_MAX),
-                                      is_two_complemented(false)
+big_integer::big_integer(limb_vector const& number, bool sign, bool two_complemented) :
+                                                sign(sign), number(number), is_two_complemented(two_complemented)
 {
-    //this->normalize();
+    this->normalize();
 }
 
 inline uint32_t big_integer::digit_in_abs_format(size_t n) const
@@ -55,33 +61,240 @@ inline uint32_t big_integer::digit_in_twos_complement(size_t n) const
         return (sign ? UINT32_MAX : 0);
     if (first_non_zero_index < n)
         return (sign ? ~number[n] : number[n]);
-    if (!sign)
-        return number[n];
+    // the lowest non-zero limb of a negative value is negated, not inverted
+    return (sign ? 0u - number[n] : number[n]);
+}
+
+inline uint64_t big_integer::low_magnitude() const
+{
+    if (size() == 1)
+        return number[0];
+    return number[0] | (static_cast<uint64_t>(number[1]) << LOG_BASE);
+}
+
+inline uint64_t big_integer::low_twos_complement() const
+{
+    return sign ? ~low_magnitude() + 1 : low_magnitude();
+}
+
+void big_integer::assign_magnitude(uint64_t magnitude, bool sign)
+{
+    auto low = static_cast<uint32_t>(magnitude);
+    auto high = static_cast<uint32_t>(magnitude >> LOG_BASE);
+
+    number.resize_uninitialized(high ? 2 : 1);
+    uint32_t* d = number.mutable_data();
+    d[0] = low;
+    if (high)
+        d[1] = high;
+    this->sign = sign && magnitude;
+    first_non_zero_index = (low ? 0 : (high ? 1 : SIZE_MAX));
+    is_two_complemented = false;
+}
+
+big_integer big_integer::from_magnitude(uint64_t magnitude, bool sign)
+{
+    big_integer result;
+    result.assign_magnitude(magnitude, sign);
+    return result;
+}
 
-    // have to keep first non-zero and all less not inverted;
-    uint mask = 0;
-    uint32_t i = 0;
-    while (!(number[n] & (1u << i))) {
-        mask ^= (1u << i);
-        ++i;
+// bits above the low 64 are all copies of the sign bit
+big_integer big_integer::from_twos_complement(uint64_t low, bool negative)
+{
+    return from_magnitude(negative ? ~low + 1 : low, negative);
+}
+
+void big_integer::add_word(uint64_t magnitude, bool negative)
+{
+    if (magnitude == 0)
+        return;
+    if (is_zero())
+    {
+        assign_magnitude(magnitude, negative);
+        return;
     }
-    mask = ~(mask ^ (1u << i));
-    return number[n] ^ mask;
+
+    if (sign == negative)
+    {
+        uint32_t* d = number.mutable_data();
+        size_t n = size();
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n && (magnitude || carry); ++i, magnitude >>= LOG_BASE)
+        {
+            uint64_t sum = static_cast<uint64_t>(d[i]) + static_cast<uint32_t>(magnitude) + carry;
+            d[i] = static_cast<uint32_t>(sum);
+            carry = sum >> LOG_BASE;
+        }
+        for (; magnitude || carry; magnitude >>= LOG_BASE)
+        {
+            uint64_t sum = static_cast<uint64_t>(static_cast<uint32_t>(magnitude)) + carry;
+            number.push_back(static_cast<uint32_t>(sum));
+            carry = sum >> LOG_BASE;
+        }
+    }
+    else
+    {
+        if (size() <= 2 && low_magnitude() < magnitude)
+        {
+            assign_magnitude(magnitude - low_magnitude(), negative);
+            return;
+        }
+
+        uint32_t* d = number.mutable_data();
+        size_t n = size();
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < n && (magnitude || borrow); ++i, magnitude >>= LOG_BASE)
+        {
+            uint64_t diff = static_cast<uint64_t>(d[i]) - static_cast<uint32_t>(magnitude) - borrow;
+            d[i] = static_cast<uint32_t>(diff);
+            borrow = diff >> (2 * LOG_BASE - 1);
+        }
+    }
+    normalize();
 }
 
+void big_integer::mul_word(uint64_t magnitude, bool negative)
+{
+    if (magnitude >> LOG_BASE)
+    {
+        *this = *this * from_magnitude(magnitude, negative);
+        return;
+    }
+    if (magnitude == 0 || is_zero())
+    {
+        assign_magnitude(0, false);
+        return;
+    }
+
+    uint32_t* d = number.mutable_data();
+    uint32_t carry = mpn::mul_1(d, d, size(), static_cast<uint32_t>(magnitude));
+    if (carry)
+        number.push_back(carry);
+    sign ^= negative;
+    normalize();
+}
+
+void big_integer::div_word(uint64_t magnitude, bool negative)
+{
+    if (magnitude >> LOG_BASE)
+    {
+        *this = *this / from_magnitude(magnitude, negative);
+        return;
+    }
+
+    uint32_t* d = number.mutable_data();
+    mpn::divrem_1(d, d, size(), static_cast<uint32_t>(magnitude));
+    sign ^= negative;
+    normalize();
+}
+
+uint64_t big_integer::mod_word(uint64_t magnitude) const
+{
+    if (magnitude >> LOG_BASE)
+        return (*this % from_magnitude(magnitude, false)).low_magnitude();
+
+    return mpn::mod_1(number.cbegin(), size(), static_cast<uint32_t>(magnitude));
+}
+
+int big_integer::compare_word(uint64_t magnitude, bool negative) const
+{
+    if (sign != negative)
+        return sign ? -1 : 1;
+
+    int abs_cmp;
+    if (size() > 2)
+        abs_cmp = 1;
+    else
+    {
+        uint64_t own = low_magnitude();
+        abs_cmp = (own < magnitude ? -1 : (own > magnitude ? 1 : 0));
+    }
+    return sign ? -abs_cmp : abs_cmp;
+}
+
+bool big_integer::fits_int64() const
+{
+    return size() <= 2 && low_magnitude() <= static_cast<uint64_t>(INT64_MAX) + (sign ? 1 : 0);
+}
+
+bool big_integer::fits_uint64() const
+{
+    return !sign && size() <= 2;
+}
+
+int64_t big_integer::to_int64() const
+{
+    return static_cast<int64_t>(to_uint64());
+}
+
+uint64_t big_integer::to_uint64() const
+{
+    uint64_t low = digit_in_abs_format(0) | (static_cast<uint64_t>(digit_in_abs_format(1)) << LOG_BASE);
+    return sign ? ~low + 1 : low;
+}
+
+#ifdef __SIZEOF_INT128__
+bool big_integer::fits_int128() const
+{
+    if (size() > 4)
+        return false;
+    uint128_t limit = ~static_cast<uint128_t>(0) >> 1;
+    uint128_t low = to_uint128();
+    return sign ? ~low + 1 <= limit + 1 : low <= limit;
+}
+
+bool big_integer::fits_uint128() const
+{
+    return !sign && size() <= 4;
+}
+
+int128_t big_integer::to_int128() const
+{
+    return static_cast<int128_t>(to_uint128());
+}
+
+uint128_t big_integer::to_uint128() const
+{
+    uint128_t low = 0;
+    for (size_t i = 4; i-- > 0;)
+        low = (low << LOG_BASE) | digit_in_abs_format(i);
+    return sign ? ~low + 1 : low;
+}
+#endif
+
 big_integer from_string(std::string const& str)
 {
-    big_integer result;
+    static const size_t CHUNK_DIGITS = 9;
+    static const uint32_t POW10[CHUNK_DIGITS + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+                                                     100000000, 1000000000};
+
+    size_t i = (str[0] == '-' ? 1 : 0);
+    size_t digits = str.size() - i;
 
-    for (size_t i = (str[0] == '-' ? 1 : 0); i < str.size(); i++)
+    // every chunk of nine digits adds at most one limb
+    limb_vector limbs;
+    limbs.resize_uninitialized(digits / CHUNK_DIGITS + 2);
+    uint32_t* d = limbs.mutable_data();
+    size_t n = 0;
+
+    size_t chunk = (digits % CHUNK_DIGITS ? digits % CHUNK_DIGITS : CHUNK_DIGITS);
+    for (; i < str.size(); chunk = CHUNK_DIGITS)
     {
-        result *= 10;
-        result += str[i] - '0';
+        uint32_t value = 0;
+        for (size_t k = 0; k < chunk; ++k, ++i)
+            value = value * 10 + static_cast<uint32_t>(str[i] - '0');
+
+        uint32_t high = mpn::mul_1(d, d, n, POW10[chunk]);
+        high += mpn::add_1(d, d, n, value);
+        if (high)
+            d[n++] = high;
     }
-    if (str[0] == '-')
-        result.sign = true;
-    result.normalize();
-    return result;
+    if (n == 0)
+        d[n++] = 0;
+    limbs.resize_uninitialized(n);
+
+    return big_integer(limbs, str[0] == '-');
 }
 
 big_integer::big_integer(std::string const& str) : big_integer(from_string(str)) {}
@@ -91,13 +304,8 @@ void big_integer::normalize()
     if (is_two_complemented && sign)
     {
         // have to translate to abs format
-        size_t i = 0;
-        for (; i < size(); ++i)
-        {
-            if (number[i])
-                break;
-        }
-        if (i == size())
+        uint32_t* d = number.mutable_data();
+        if (!mpn::neg(d, d, size()))
         {
             number = vector(1, 0);
             sign = false;
@@ -105,29 +313,22 @@ void big_integer::normalize()
             first_non_zero_index = SIZE_MAX;
             return;
         }
-
-        uint mask = 0;
-        uint32_t j = 0;
-        while (!(number[i] & (1u << j)))
-        {
-            mask ^= (1u << j);
-            ++j;
-        }
-        mask = ~(mask ^ (1u << j));
-        number[i] ^= mask;
-
-        for (++i; i < size(); ++i)
-            number[i] = ~number[i];
     }
 
-
-    while (number.size() > 1 && number.back() == 0)
-        number.pop_back();
+    const uint32_t* d = number.cbegin();
+    size_t n = size();
+    while (n > 1 && d[n - 1] == 0)
+        --n;
+    if (n != size())
+    {
+        number.resize_uninitialized(n);
+        d = number.cbegin();
+    }
 
     first_non_zero_index = SIZE_MAX;
-    for (size_t i = 0; i < size(); ++i)
+    for (size_t i = 0; i < n; ++i)
     {
-        if (number[i])
+        if (d[i])
         {
             first_non_zero_index = i;
             break;
@@ -135,7 +336,7 @@ void big_integer::normalize()
     }
     if (first_non_zero_index == SIZE_MAX)
     {
-        number = optimized_vector(1, 0);
+        number = limb_vector(1, 0);
         sign = false;
         is_two_complemented = false;
         first_non_zero_index = SIZE_MAX;
@@ -184,86 +385,202 @@ big_integer abs(big_integer const& x)
     return result;
 }
 
-big_integer operator+(big_integer a, const big_integer &b)
+bool big_integer::is_zero() const
 {
-    if (!a.sign && b.sign)
-        return a - abs(b);
-    if (a.sign && !b.sign)
-        return b - abs(a);
+    return first_non_zero_index == SIZE_MAX;
+}
 
-    size_t max_len = std::max(a.size(), b.size());
-    optimized_vector result(max_len + 1);
+int big_integer::sgn() const
+{
+    return is_zero() ? 0 : (sign ? -1 : 1);
+}
 
-    size_t i = 0;
-    uint64_t tmp = 0, carry = 0;
-    for (; i < max_len; ++i)
+size_t big_integer::bit_length() const
+{
+    if (is_zero())
+        return 0;
+    return size() * LOG_BASE - __builtin_clz(number[size() - 1]);
+}
+
+size_t big_integer::popcount() const
+{
+    const uint32_t* d = number.cbegin();
+    size_t result = 0;
+    for (size_t i = 0; i < size(); ++i)
+        result += __builtin_popcount(d[i]);
+    return result;
+}
+
+size_t big_integer::count_trailing_zeros() const
+{
+    if (is_zero())
+        return 0;
+    return first_non_zero_index * LOG_BASE + __builtin_ctz(number[first_non_zero_index]);
+}
+
+bool big_integer::test_bit(size_t n) const
+{
+    return (digit_in_twos_complement(n / LOG_BASE) >> (n % LOG_BASE)) & 1u;
+}
+
+void big_integer::change_magnitude_bit(size_t n, bit_operation op)
+{
+    size_t limb = n / LOG_BASE;
+    if (limb >= size())
     {
-        uint64_t x = a.digit_in_abs_format(i);
-        uint64_t y = b.digit_in_abs_format(i);
-        if (x < y)
-            x += carry;
-        else
-            y += carry;
-        tmp = x + y;
-        result[i] = static_cast<uint32_t>(tmp);
-        carry = tmp >> big_integer::LOG_BASE;
+        if (op == CLEAR_BIT)
+            return;
+        number.resize(limb + 1);
     }
+    uint32_t mask = 1u << (n % LOG_BASE);
+    uint32_t* d = number.mutable_data();
+    if (op == SET_BIT)
+        d[limb] |= mask;
+    else if (op == CLEAR_BIT)
+        d[limb] &= ~mask;
+    else
+        d[limb] ^= mask;
+}
 
-    uint64_t x = a.digit_in_abs_format(i);
-    uint64_t y = b.digit_in_abs_format(i);
-    if (x < y)
-        x += carry;
+void big_integer::change_bit(size_t n, bit_operation op)
+{
+    if (!sign)
+        change_magnitude_bit(n, op);
     else
-        y += carry;
-    tmp = x + y;
-    result[i] = static_cast<uint32_t>(tmp);
+    {
+        // the two's complement bits of -m are those of ~(m - 1)
+        uint32_t* d = number.mutable_data();
+        mpn::sub_1(d, d, size(), 1);
+        change_magnitude_bit(n, op == SET_BIT ? CLEAR_BIT : (op == CLEAR_BIT ? SET_BIT : FLIP_BIT));
+        d = number.mutable_data();
+        if (mpn::add_1(d, d, size(), 1))
+            number.push_back(1);
+    }
+    normalize();
+}
 
-    bool ans_sign = a.sign;
-    return big_integer(result, ans_sign);
+void big_integer::set_bit(size_t n)
+{
+    change_bit(n, SET_BIT);
 }
 
-big_integer& big_integer::operator+=(big_integer const &rhs)
+void big_integer::clear_bit(size_t n)
 {
-    return *this = *this + rhs;
+    change_bit(n, CLEAR_BIT);
 }
 
-big_integer operator-(big_integer a, big_integer const &b)
+void big_integer::flip_bit(size_t n)
 {
-    if (!a.sign && b.sign)
-        return a + abs(b);
-    if (a.sign && !b.sign)
-        return -(abs(a) + b);
+    change_bit(n, FLIP_BIT);
+}
 
-    if (a.sign && b.sign)
-        return (abs(b) - abs(a));
+void big_integer::truncate_to_bits(size_t n)
+{
+    size_t limbs = (n + LOG_BASE - 1) / LOG_BASE;
+    if (limbs > size())
+        return;
+    if (n == 0)
+    {
+        *this = big_integer();
+        return;
+    }
+    number.resize_uninitialized(limbs);
+    if (n % LOG_BASE)
+        number.mutable_data()[limbs - 1] &= (1u << (n % LOG_BASE)) - 1;
+    normalize();
+}
 
-    if (a < b)
+void big_integer::mod_2exp(size_t n)
+{
+    truncate_to_bits(n);
+    if (!sign)
+        return;
+
+    // 2^n - |x| mod 2^n is the n-bit two's complement of the magnitude
+    size_t limbs = (n + LOG_BASE - 1) / LOG_BASE;
+    number.resize(limbs);
+    uint32_t* d = number.mutable_data();
+    mpn::neg(d, d, limbs);
+    if (n % LOG_BASE)
+        d[limbs - 1] &= (1u << (n % LOG_BASE)) - 1;
+    sign = false;
+    normalize();
+}
+
+big_integer big_integer::add_magnitudes(big_integer const& a, big_integer const& b, bool sign)
+{
+    const uint32_t* x = a.number.cbegin();
+    const uint32_t* y = b.number.cbegin();
+    size_t x_len = a.size(), y_len = b.size();
+    if (x_len < y_len)
     {
-        //std::cerr << a << std::endl << b << std::endl << b - a << std::endl;
-        return -(b - a);
+        std::swap(x, y);
+        std::swap(x_len, y_len);
     }
 
-    size_t max_len = std::max(a.size(), b.size());
-    optimized_vector result(max_len + 1);
+    limb_vector result;
+    result.resize_uninitialized(x_len + 1);
+    uint32_t* r = result.mutable_data();
+    r[x_len] = mpn::add(r, x, x_len, y, y_len);
+    return big_integer(result, sign);
+}
+
+big_integer big_integer::sub_magnitudes(big_integer const& a, big_integer const& b, bool sign)
+{
+    const uint32_t* x = a.number.cbegin();
+    const uint32_t* y = b.number.cbegin();
+    size_t x_len = a.size(), y_len = b.size();
+    int cmp = mpn::cmp(x, x_len, y, y_len);
+    if (cmp == 0)
+        return big_integer();
+    if (cmp < 0)
+    {
+        std::swap(x, y);
+        std::swap(x_len, y_len);
+        sign = !sign;
+    }
+
+    limb_vector result;
+    result.resize_uninitialized(x_len);
+    mpn::sub(result.mutable_data(), x, x_len, y, y_len);
+    return big_integer(result, sign);
+}
 
-    size_t i = 0;
-    uint64_t tmp = 0, carry = 0;
-    for (; i < max_len; ++i)
+big_integer operator+(big_integer a, const big_integer &b)
+{
+    if (a.size() <= 2 && b.size() <= 2)
     {
-        uint64_t x = a.digit_in_abs_format(i);
-        uint64_t y = b.digit_in_abs_format(i);
-        tmp = x - y - carry;
-        result[i] = static_cast<uint32_t>(tmp);
-        carry = (tmp >> big_integer::LOG_BASE > 0 ? 1 : 0);
+        uint64_t x = a.low_magnitude(), y = b.low_magnitude(), sum;
+        if (a.sign != b.sign)
+            return x >= y ? big_integer::from_magnitude(x - y, a.sign) : big_integer::from_magnitude(y - x, b.sign);
+        if (!__builtin_add_overflow(x, y, &sum))
+            return big_integer::from_magnitude(sum, a.sign);
     }
 
-    uint64_t x = a.digit_in_abs_format(i);
-    uint64_t y = b.digit_in_abs_format(i);
-    tmp = x - y - carry;
-    result[i] = static_cast<uint32_t>(tmp);
+    if (a.sign != b.sign)
+        return big_integer::sub_magnitudes(a, b, a.sign);
+    return big_integer::add_magnitudes(a, b, a.sign);
+}
+
+big_integer& big_integer::operator+=(big_integer const &rhs)
+{
+    return *this = *this + rhs;
+}
+
+big_integer operator-(big_integer a, big_integer const &b)
+{
+    if (a.size() <= 2 && b.size() <= 2)
+    {
+        uint64_t x = a.low_magnitude(), y = b.low_magnitude(), sum;
+        if (a.sign == b.sign)
+            return x >= y ? big_integer::from_magnitude(x - y, a.sign) : big_integer::from_magnitude(y - x, !a.sign);
+        if (!__builtin_add_overflow(x, y, &sum))
+            return big_integer::from_magnitude(sum, a.sign);
+    }
 
-    bool ans_sign = a.sign;
-    return big_integer(result, ans_sign);
+    if (a.sign != b.sign)
+        return big_integer::add_magnitudes(a, b, a.sign);
+    return big_integer::sub_magnitudes(a, b, a.sign);
 }
 
 big_integer& big_integer::operator-=(big_integer const &rhs)
@@ -273,148 +590,871 @@ big_integer& big_integer::operator-=(big_integer const &rhs)
 
 big_integer operator*(big_integer a, big_integer const &b)
 {
-    if (a == 0 || b == 0)
-        return 0;
+    uint64_t product;
+    if (a.size() <= 2 && b.size() <= 2 && !__builtin_mul_overflow(a.low_magnitude(), b.low_magnitude(), &product))
+        return big_integer::from_magnitude(product, a.sign ^ b.sign);
+
+    const uint32_t* x = a.number.cbegin();
+    const uint32_t* y = b.number.cbegin();
+    size_t x_len = a.size(), y_len = b.size();
+    if (x_len < y_len)
+    {
+        std::swap(x, y);
+        std::swap(x_len, y_len);
+    }
 
-    size_t a_len = a.size(), b_len = b.size();
-    optimized_vector tmp(a_len + b_len + 1);
-    optimized_vector ans(a_len + b_len + 1, 0);
+    limb_vector ans;
+    ans.resize_uninitialized(x_len + y_len);
+    // x * x shares the buffer between the copy and the original
+    if (x == y && x_len == y_len)
+        mpn::sqr(ans.mutable_data(), x, x_len);
+    else
+        mpn::mul(ans.mutable_data(), x, x_len, y, y_len);
+    return big_integer(ans, a.sign ^ b.sign);
+}
 
-    for (size_t i = 0; i < b_len; i++)
+big_integer& big_integer::operator*=(big_integer const &rhs)
+{
+    return *this = *this * rhs;
+}
+
+void big_integer::add_product(big_integer const& a, big_integer const& b, bool negative)
+{
+    if (a.is_zero() || b.is_zero())
+        return;
+    negative ^= a.sign ^ b.sign;
+
+    uint64_t product;
+    if (a.size() <= 2 && b.size() <= 2 && !__builtin_mul_overflow(a.low_magnitude(), b.low_magnitude(), &product))
+    {
+        add_word(product, negative);
+        return;
+    }
+
+    if (is_zero())
+        sign = negative;
+    bool subtract = (sign != negative);
+
+    // the operands' limbs stay valid: a shared buffer is detached from *this, not from them
+    const uint32_t* x = a.number.cbegin();
+    const uint32_t* y = b.number.cbegin();
+    size_t x_len = a.size(), y_len = b.size();
+    if (x_len < y_len)
     {
-        for (size_t j = 0; j < tmp.size(); j++)
-            tmp[j] = 0;
+        std::swap(x, y);
+        std::swap(x_len, y_len);
+    }
 
-        uint64_t mul = 0, carry = 0;
-        for (size_t j = 0; j < a_len + 1; j++)
+    // a sum needs one limb more than its longer operand, a difference doesn't
+    size_t len = std::max(size(), x_len + y_len) + (subtract ? 0 : 1);
+    number.resize(len);
+    uint32_t* d = number.mutable_data();
+    if (subtract)
+    {
+        // |this| < |a * b|: the difference is left in two's complement
+        if (mpn::submul(d, len, x, x_len, y, y_len))
         {
-            mul = static_cast<uint64_t>(a.digit_in_abs_format(j)) * b.number[i] + carry;
-            carry = mul >> big_integer::LOG_BASE;
-            tmp[j] = static_cast<uint32_t>(mul);
+            mpn::neg(d, d, len);
+            sign = !sign;
         }
+    }
+    else
+        mpn::addmul(d, len, x, x_len, y, y_len);
+    normalize();
+}
+
+big_integer& addmul(big_integer& acc, big_integer const& a, big_integer const& b)
+{
+    if (&acc == &a || &acc == &b)
+        return acc += a * b;
+    acc.add_product(a, b, false);
+    return acc;
+}
 
-        carry = 0;
-        uint64_t sum = 0;
-        for (size_t j = i; j < ans.size(); j++)
+big_integer& submul(big_integer& acc, big_integer const& a, big_integer const& b)
+{
+    if (&acc == &a || &acc == &b)
+        return acc -= a * b;
+    acc.add_product(a, b, true);
+    return acc;
+}
+
+bool big_integer::rounds_away(rounding mode, bool a_sign, bool b_sign)
+{
+    // a non-zero truncated remainder moves the quotient one further from zero when
+    // the exact quotient is negative (floor), positive (ceil), or a is negative (Euclidean)
+    switch (mode)
+    {
+    case FLOOR:
+        return a_sign != b_sign;
+    case CEIL:
+        return a_sign == b_sign;
+    case EUCLID:
+        return a_sign;
+    default:
+        return false;
+    }
+}
+
+bool big_integer::adjusted_remainder_sign(rounding mode, bool b_sign)
+{
+    // the remainder |b| - r left after moving the quotient away from zero
+    return mode == FLOOR ? b_sign : (mode == CEIL ? !b_sign : false);
+}
+
+void big_integer::divide(big_integer const& a, big_integer const& b, big_integer* quotient, big_integer* remainder,
+                         rounding mode)
+{
+    const uint32_t* x = a.number.cbegin();
+    const uint32_t* y = b.number.cbegin();
+    size_t x_len = a.size(), y_len = b.size();
+    bool a_sign = a.sign, b_sign = b.sign;
+
+    if (x_len <= 2 && y_len <= 2)
+    {
+        uint64_t xm = a.low_magnitude(), ym = b.low_magnitude();
+        uint64_t qm = xm / ym, rm = xm % ym;
+        bool r_sign = a_sign;
+        if (rm && rounds_away(mode, a_sign, b_sign))
         {
-            sum = static_cast<uint64_t>(ans[j]) + tmp[j - i] + carry;
-            ans[j] = static_cast<uint32_t>(sum);
-            carry = sum >> big_integer::LOG_BASE;
+            // ym > rm > 0, so ym >= 2 and qm + 1 doesn't overflow
+            ++qm;
+            rm = ym - rm;
+            r_sign = adjusted_remainder_sign(mode, b_sign);
         }
+        if (quotient)
+            *quotient = from_magnitude(qm, a_sign ^ b_sign);
+        if (remainder)
+            *remainder = from_magnitude(rm, r_sign);
+        return;
     }
 
-    return big_integer(ans, a.sign ^ b.sign);
+    // the quotient gets a spare top limb for the rounding increment
+    limb_vector q, r;
+    size_t qn;
+    if (mpn::cmp(x, x_len, y, y_len) < 0)
+    {
+        qn = 1;
+        q.assign(2, 0);
+        r.assign(x, x + x_len);
+        r.resize(y_len);
+    }
+    else
+    {
+        qn = x_len - y_len + 1;
+        q.resize_uninitialized(qn + 1);
+        r.resize_uninitialized(y_len);
+        uint32_t* qd = q.mutable_data();
+        if (y_len == 1)
+            r.mutable_data()[0] = mpn::divrem_1(qd, x, x_len, y[0]);
+        else
+            mpn::tdiv_qr(qd, r.mutable_data(), x, x_len, y, y_len);
+        qd[qn] = 0;
+    }
+
+    bool r_sign = a_sign;
+    if (rounds_away(mode, a_sign, b_sign) && mpn::normalized_size(r.cbegin(), y_len) != 0)
+    {
+        uint32_t* qd = q.mutable_data();
+        uint32_t* rd = r.mutable_data();
+        mpn::add_1(qd, qd, qn + 1, 1);
+        mpn::sub_n(rd, y, rd, y_len);
+        r_sign = adjusted_remainder_sign(mode, b_sign);
+    }
+
+    // outputs may alias the inputs, so they are written last
+    if (quotient)
+        *quotient = big_integer(q, a_sign ^ b_sign);
+    if (remainder)
+        *remainder = big_integer(r, r_sign);
 }
 
-big_integer& big_integer::operator*=(big_integer const &rhs)
+void tdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b)
 {
-    return *this = *this * rhs;
+    big_integer::divide(a, b, &q, &r, big_integer::TRUNCATE);
 }
 
-std::pair<big_integer, uint32_t> big_integer::divide_by_short(uint32_t x, bool sign)
+void fdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b)
 {
-    uint32_t carry = 0;
-    big_integer result = *this;
+    big_integer::divide(a, b, &q, &r, big_integer::FLOOR);
+}
+
+void cdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b)
+{
+    big_integer::divide(a, b, &q, &r, big_integer::CEIL);
+}
+
+void ediv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b)
+{
+    big_integer::divide(a, b, &q, &r, big_integer::EUCLID);
+}
+
+namespace
+{
+    // r = a * b on normalized spans, returns the normalized size of r
+    size_t mul_normalized(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+    {
+        if (an < bn)
+        {
+            std::swap(a, b);
+            std::swap(an, bn);
+        }
+        if (a == b && an == bn)
+            mpn::sqr(r, a, an);
+        else
+            mpn::mul(r, a, an, b, bn);
+        return mpn::normalized_size(r, an + bn);
+    }
+}
 
-    for (size_t i = this->size() - 1; i > 0; i--)
+big_integer pow(big_integer const& base, uint64_t exp)
+{
+    if (exp == 0)
+        return big_integer(1);
+    bool negative = base.sign && (exp & 1u);
+    if (base.is_zero())
+        return base;
+
+    // base = odd * 2^zeros, and the power of two becomes a shift of odd^exp
+    size_t zeros = base.count_trailing_zeros();
+    size_t odd_bits = base.bit_length() - zeros;
+    size_t odd_limbs = (odd_bits + big_integer::LOG_BASE - 1) / big_integer::LOG_BASE;
+    size_t shift = zeros * exp;
+
+    // both buffers hold the result: a product of two values below 2^k and 2^l fits in k + l bits,
+    // plus a limb for the rounding of the operand sizes
+    size_t cap = (odd_bits * exp + shift) / big_integer::LOG_BASE + 2;
+    limb_vector result_storage, scratch_storage;
+    result_storage.resize_uninitialized(cap);
+    scratch_storage.resize_uninitialized(cap);
+    uint32_t* r = result_storage.mutable_data();
+    uint32_t* t = scratch_storage.mutable_data();
+
+    limb_vector odd;
+    odd.resize_uninitialized(odd_limbs);
     {
-        uint64_t cur = result.number[i] + carry * big_integer::BASE;
-        result.number[i] = static_cast<uint32_t>(cur / x);
-        carry = static_cast<uint32_t>(cur % x);
+        size_t limbs = zeros / big_integer::LOG_BASE;
+        auto bits = static_cast<unsigned>(zeros % big_integer::LOG_BASE);
+        size_t n = base.size() - limbs;
+        uint32_t* o = odd.mutable_data();
+        if (bits)
+        {
+            // only the low odd_limbs words are needed, the shifted-in top is zero
+            basic_optimized_vector<BIG_INTEGER_INLINE_LIMBS> tmp;
+            tmp.resize_uninitialized(n);
+            mpn::rshift(tmp.mutable_data(), base.number.cbegin() + limbs, n, bits);
+            std::copy(tmp.cbegin(), tmp.cbegin() + odd_limbs, o);
+        }
+        else
+            std::copy(base.number.cbegin() + limbs, base.number.cbegin() + limbs + odd_limbs, o);
     }
-    uint64_t cur = result.number[0] + carry * big_integer::BASE;
-    result.number[0] = static_cast<uint32_t>(cur / x);
-    carry = static_cast<uint32_t>(cur % x);
-    result.sign = this->sign ^ sign;
 
-    return {result, carry};
+    size_t rn;
+    if (odd_bits == 1)
+    {
+        // a power of two: only the shift is left
+        r[0] = 1;
+        rn = 1;
+    }
+    else
+    {
+        // sliding window: odd powers base^1, base^3, ..., base^(2^w - 1) are precomputed
+        size_t exp_bits = 64 - __builtin_clzll(exp);
+        unsigned window = exp_bits > 24 ? 4 : (exp_bits > 8 ? 3 : (exp_bits > 2 ? 2 : 1));
+        std::vector<limb_vector> odd_powers(static_cast<size_t>(1) << (window - 1));
+        odd_powers[0] = odd;
+        if (window > 1)
+        {
+            limb_vector square;
+            square.resize_uninitialized(2 * odd_limbs);
+            size_t sn = mul_normalized(square.mutable_data(), odd.cbegin(), odd_limbs, odd.cbegin(), odd_limbs);
+            for (size_t k = 1; k < odd_powers.size(); ++k)
+            {
+                limb_vector const& prev = odd_powers[k - 1];
+                limb_vector& next = odd_powers[k];
+                next.resize_uninitialized(prev.size() + sn);
+                next.resize_uninitialized(mul_normalized(next.mutable_data(), prev.cbegin(), prev.size(),
+                                                         square.cbegin(), sn));
+            }
+        }
+
+        rn = 0;
+        for (size_t i = exp_bits; i-- > 0;)
+        {
+            if (!((exp >> i) & 1u))
+            {
+                rn = mul_normalized(t, r, rn, r, rn);
+                std::swap(r, t);
+                continue;
+            }
+
+            // the longest window of at most w bits that starts at bit i and ends with a one
+            size_t low = i + 1 > window ? i + 1 - window : 0;
+            while (!((exp >> low) & 1u))
+                ++low;
+            size_t value = static_cast<size_t>((exp >> low) & ((1ull << (i - low + 1)) - 1));
+            limb_vector const& factor = odd_powers[value >> 1];
+
+            if (rn == 0)
+            {
+                std::copy(factor.cbegin(), factor.cend(), r);
+                rn = factor.size();
+            }
+            else
+            {
+                for (size_t k = low; k <= i; ++k)
+                {
+                    rn = mul_normalized(t, r, rn, r, rn);
+                    std::swap(r, t);
+                }
+                rn = mul_normalized(t, r, rn, factor.cbegin(), factor.size());
+                std::swap(r, t);
+            }
+            i = low;
+        }
+    }
+
+    // the final value goes to the other buffer, shifted in the same pass
+    size_t limbs = shift / big_integer::LOG_BASE;
+    auto bits = static_cast<unsigned>(shift % big_integer::LOG_BASE);
+    std::fill(t, t + limbs, 0);
+    if (bits)
+        t[limbs + rn] = mpn::lshift(t + limbs, r, rn, bits);
+    else
+    {
+        std::copy(r, r + rn, t + limbs);
+        t[limbs + rn] = 0;
+    }
+    size_t total = limbs + rn + 1;
+
+    limb_vector& final_storage = (t == result_storage.cbegin()) ? result_storage : scratch_storage;
+    final_storage.resize_uninitialized(total);
+    return big_integer(final_storage, negative);
 }
 
-big_integer operator/(big_integer a, big_integer const &b) {
-    big_integer aa(abs(a));
-    big_integer bb(abs(b));
+big_integer divexact(big_integer const& a, big_integer const& b)
+{
+    if (a.size() <= 2 && b.size() <= 2)
+        return big_integer::from_magnitude(a.low_magnitude() / b.low_magnitude(), a.sign ^ b.sign);
+    if (a.size() < b.size())
+        return big_integer();
 
-    if (aa < bb)
-        return 0;
-    if (aa == bb)
-        return 1;
-    if (bb.size() == 1)
-        return a.divide_by_short(b.number[0], b.sign).first;
+    limb_vector q;
+    q.resize_uninitialized(a.size() - b.size() + 1);
+    mpn::divexact(q.mutable_data(), a.number.cbegin(), a.size(), b.number.cbegin(), b.size());
+    return big_integer(q, a.sign ^ b.sign);
+}
 
-    auto f = static_cast<uint32_t>(big_integer::BASE / static_cast<uint64_t>(bb.number.back() + 1));
-    aa *= big_integer(f);
-    bb *= big_integer(f);
+namespace
+{
+    // gcd and gcdext reduce operands of at least GCD_DC_THRESHOLD limbs with the half-GCD, whose
+    // recursion stops at HGCD_THRESHOLD limbs; below them Lehmer's algorithm is faster
+    const size_t HGCD_THRESHOLD = 300;
+    const size_t GCD_DC_THRESHOLD = 4000;
+
+    // (a, b) = m * (a', b') for the reduced pair (a', b'); the entries are non-negative and det, the
+    // determinant, is +1 or -1
+    struct hgcd_matrix
+    {
+        big_integer m00 = 1, m01 = 0, m10 = 0, m11 = 1;
+        int det = 1;
+    };
 
-    size_t n = aa.size();
-    size_t m = bb.size();
-    optimized_vector ans(n - m + 1);
-    big_integer reminder(0);
+    // m = m * n
+    void hgcd_mul(hgcd_matrix& m, hgcd_matrix const& n)
+    {
+        hgcd_matrix r;
+        r.m00 = m.m00 * n.m00 + m.m01 * n.m10;
+        r.m01 = m.m00 * n.m01 + m.m01 * n.m11;
+        r.m10 = m.m10 * n.m00 + m.m11 * n.m10;
+        r.m11 = m.m10 * n.m01 + m.m11 * n.m11;
+        r.det = m.det * n.det;
+        m = r;
+    }
 
-    for (size_t i = n - 1; i > n - m; i--)
+    // m = m * [[1, q], [0, 1]], the matrix of a -= q * b
+    void hgcd_mul_elementary(hgcd_matrix& m, big_integer const& q)
     {
-        reminder <<= big_integer::LOG_BASE;
-        reminder.number[0] = aa.number[i];
+        addmul(m.m01, m.m00, q);
+        addmul(m.m11, m.m10, q);
     }
 
-    uint64_t div_high_digit = bb.number.back();
+    // m = m * [[0, 1], [1, 0]], the matrix of swapping a and b
+    void hgcd_swap_columns(hgcd_matrix& m)
+    {
+        m.m00.swap(m.m01);
+        m.m10.swap(m.m11);
+        m.det = -m.det;
+    }
 
-    for (size_t i = n - m; i > 0; i--)
+    // (a, b) = m^-1 * (a, b), where (top_a, top_b) is m^-1 already applied to a and b shifted right by
+    // p limbs: only the low p limbs are left to multiply, as the inverse is det times the adjugate
+    void hgcd_apply_inverse(hgcd_matrix const& m, big_integer& a, big_integer& b, big_integer const& top_a,
+                            big_integer const& top_b, size_t p)
     {
-        //Sstd::cerr << i << std::endl;
-        reminder <<= big_integer::LOG_BASE;
-        reminder.number[0] = aa.number[i];
+        size_t bits = p * mpn::LIMB_BITS;
+        big_integer low_a = a, low_b = b;
+        low_a.truncate_to_bits(bits);
+        low_b.truncate_to_bits(bits);
+        big_integer x = m.m11 * low_a - m.m01 * low_b;
+        big_integer y = m.m00 * low_b - m.m10 * low_a;
+        a = top_a << bits;
+        b = top_b << bits;
+        if (m.det > 0)
+        {
+            a += x;
+            b += y;
+        }
+        else
+        {
+            a -= x;
+            b -= y;
+        }
+    }
 
-        uint64_t rem_high_digits = reminder.number.back();
-        if (reminder.size() > m)
+    // x > B^s
+    bool above(big_integer const& x, size_t s)
+    {
+        size_t bits = s * mpn::LIMB_BITS;
+        size_t length = x.bit_length();
+        return length > bits + 1 || (length == bits + 1 && x.count_trailing_zeros() != bits);
+    }
+
+    // One reduction of a, b > B^s that keeps both above B^s: a Lehmer step on the leading 64 bits when
+    // its result qualifies, otherwise a division step whose quotient is cut short if needed
+    bool hgcd_step(big_integer& a, big_integer& b, hgcd_matrix& m, size_t s)
+    {
+        if (a < b)
         {
-            rem_high_digits *= big_integer::BASE;
-            rem_high_digits += reminder.number[reminder.size() - 2];
+            a.swap(b);
+            hgcd_swap_columns(m);
         }
+        if (!above(b, s))
+            return false;
 
-        uint64_t quot_suggest = std::min(rem_high_digits / div_high_digit, big_integer::BASE - 1);
+        size_t length = a.bit_length();
+        size_t shift = length > 64 ? length - 64 : 0;
+        uint64_t top_a = (a >> shift).to_uint64(), top_b = (b >> shift).to_uint64();
+        uint32_t la[2] = {static_cast<uint32_t>(top_a), static_cast<uint32_t>(top_a >> mpn::LIMB_BITS)};
+        uint32_t lb[2] = {static_cast<uint32_t>(top_b), static_cast<uint32_t>(top_b >> mpn::LIMB_BITS)};
+        size_t an = mpn::normalized_size(la, 2), bn = mpn::normalized_size(lb, 2);
+        mpn::lehmer_matrix l;
+        if (bn != 0 && mpn::lehmer(l, la, an, lb, bn))
+        {
+            big_integer x = l.odd ? b * l.b - a * l.a : a * l.a - b * l.b;
+            big_integer y = l.odd ? a * l.c - b * l.d : b * l.d - a * l.c;
+            if (above(y, s))
+            {
+                // the inverse of Lehmer's matrix has the same entries, rearranged and all non-negative
+                hgcd_matrix n;
+                n.m00 = l.d;
+                n.m01 = l.b;
+                n.m10 = l.c;
+                n.m11 = l.a;
+                n.det = static_cast<uint64_t>(l.a) * l.d > static_cast<uint64_t>(l.b) * l.c ? 1 : -1;
+                hgcd_mul(m, n);
+                a = x;
+                b = y;
+                return true;
+            }
+        }
+
+        big_integer q, r;
+        tdiv_qr(q, r, a, b);
+        if (!above(r, s))
+        {
+            if (q == 1)
+                return false;
+            q -= 1;
+            r += b;
+        }
+        hgcd_mul_elementary(m, q);
+        a = r;
+        return true;
+    }
 
-        big_integer bb_suggest = bb * big_integer(static_cast<uint32_t>(quot_suggest));
+    // Half-GCD (Moller's formulation): for a, b of at most n limbs and s = n / 2 + 1, applies Euclid
+    // steps while both values stay above B^s and accumulates them in m. Each half of the work is a
+    // recursive call on the leading limbs, whose matrix is also valid for the full operands because
+    // the reduced leading parts exceed the matrix entries. Returns false when no step was possible.
+    bool hgcd(big_integer& a, big_integer& b, hgcd_matrix& m)
+    {
+        size_t n = std::max(a.bit_length(), b.bit_length()) / mpn::LIMB_BITS + 1;
+        size_t s = n / 2 + 1;
+        m = hgcd_matrix();
+        if (!above(a, s) || !above(b, s))
+            return false;
 
-        while (reminder < bb_suggest)
+        bool progress = false;
+        if (n >= HGCD_THRESHOLD)
         {
-            quot_suggest--;
-            bb_suggest -= bb;
+            // the leading n - p limbs bring a and b down to about 3n / 4 limbs
+            size_t p = n / 2;
+            big_integer a1 = a >> (p * mpn::LIMB_BITS), b1 = b >> (p * mpn::LIMB_BITS);
+            hgcd_matrix m1;
+            if (hgcd(a1, b1, m1))
+            {
+                hgcd_apply_inverse(m1, a, b, a1, b1, p);
+                m = m1;
+                progress = true;
+            }
+
+            // one plain step leaves at most about 3n / 4 limbs even when the leading part made no
+            // progress, and the leading limbs above 2s - n' + 1 bring them to just above s limbs
+            if (!hgcd_step(a, b, m, s))
+                return progress;
+            progress = true;
+            size_t n2 = std::max(a.bit_length(), b.bit_length()) / mpn::LIMB_BITS + 1;
+            if (n2 > s + 2)
+            {
+                size_t p2 = 2 * s - n2 + 1;
+                big_integer a2 = a >> (p2 * mpn::LIMB_BITS), b2 = b >> (p2 * mpn::LIMB_BITS);
+                hgcd_matrix m2;
+                if (hgcd(a2, b2, m2))
+                {
+                    hgcd_apply_inverse(m2, a, b, a2, b2, p2);
+                    hgcd_mul(m, m2);
+                    progress = true;
+                }
+            }
         }
+        while (hgcd_step(a, b, m, s))
+            progress = true;
+        return progress;
+    }
 
-        ans[i] = static_cast<uint32_t>(quot_suggest);
-        reminder -= bb_suggest;
+    bool gcd_dc_sized(big_integer const& a, big_integer const& b)
+    {
+        return std::min(a.bit_length(), b.bit_length()) > (GCD_DC_THRESHOLD - 1) * mpn::LIMB_BITS;
     }
 
-    //std::cerr << 0 << std::endl;
-    reminder <<= big_integer::LOG_BASE;
-    reminder.number[0] = aa.number[0];
+    // reduces a, b >= 0 with half-GCD and division steps until one of them is below GCD_DC_THRESHOLD
+    // limbs, accumulating the steps in m when it is given
+    void hgcd_reduce(big_integer& a, big_integer& b, hgcd_matrix* m)
+    {
+        while (gcd_dc_sized(a, b))
+        {
+            // even without progress the step may have swapped a and b
+            hgcd_matrix step;
+            bool progress = hgcd(a, b, step);
+            if (m)
+                hgcd_mul(*m, step);
+            if (progress)
+                continue;
+            if (a < b)
+            {
+                a.swap(b);
+                if (m)
+                    hgcd_swap_columns(*m);
+            }
+            big_integer q, r;
+            tdiv_qr(q, r, a, b);
+            if (m)
+                hgcd_mul_elementary(*m, q);
+            a = r;
+        }
+    }
+}
 
-    uint64_t rem_high_digits = reminder.number.back();
-    if (reminder.size() > m)
+big_integer gcd(big_integer const& a, big_integer const& b)
+{
+    if (gcd_dc_sized(a, b))
     {
-        rem_high_digits *= big_integer::BASE;
-        rem_high_digits += reminder.number[reminder.size() - 2];
+        big_integer x = abs(a), y = abs(b);
+        hgcd_reduce(x, y, nullptr);
+        return gcd(x, y);
     }
 
-    uint64_t quot_suggest = std::min(rem_high_digits / div_high_digit, big_integer::BASE - 1);
+    if (a.is_zero())
+        return abs(b);
+    if (b.is_zero())
+        return abs(a);
+    if (a.size() <= 2 && b.size() <= 2)
+        return big_integer::from_magnitude(mpn::gcd_2(a.low_magnitude(), b.low_magnitude()), false);
+
+    big_integer const& x = a.size() >= b.size() ? a : b;
+    big_integer const& y = a.size() >= b.size() ? b : a;
+    limb_vector g;
+    g.resize_uninitialized(y.size());
+    g.resize_uninitialized(mpn::gcd(g.mutable_data(), x.number.cbegin(), x.size(), y.number.cbegin(), y.size()));
+    return big_integer(g);
+}
 
-    big_integer bb_suggest = bb * big_integer(static_cast<uint32_t>(quot_suggest));
+big_integer lcm(big_integer const& a, big_integer const& b)
+{
+    if (a.is_zero() || b.is_zero())
+        return big_integer();
+    return abs(divexact(a, gcd(a, b)) * b);
+}
 
-    while (reminder < bb_suggest)
+void gcdext(big_integer& g, big_integer& s, big_integer& t, big_integer const& a, big_integer const& b)
+{
+    if (a.is_zero() || b.is_zero())
     {
-        quot_suggest--;
-        bb_suggest -= bb;
+        big_integer sa = b.is_zero() ? a.sgn() : 0, tb = b.sgn();
+        g = abs(a.is_zero() ? b : a);
+        s = sa;
+        t = tb;
+        return;
     }
 
-    ans[0] = static_cast<uint32_t>(quot_suggest);
-    reminder -= bb_suggest;
+    if (gcd_dc_sized(a, b))
+    {
+        // (|a|, |b|) = m * (x, y), so the cofactors of the reduced pair carry over through the adjugate
+        big_integer x = abs(a), y = abs(b);
+        hgcd_matrix m;
+        hgcd_reduce(x, y, &m);
+        big_integer gx, sx, ty;
+        gcdext(gx, sx, ty, x, y);
+        big_integer s_value = sx * m.m11 - ty * m.m10;
+        if (m.det < 0)
+            s_value = -s_value;
+
+        // the cofactor of |a| is only defined modulo |b| / g; the one closest to zero is kept
+        big_integer period = divexact(abs(b), gx);
+        s_value = s_value % period;
+        if (s_value.sgn() < 0)
+            s_value += period;
+        if (s_value > (period >> 1))
+            s_value -= period;
+        big_integer t_value = divexact(gx - abs(a) * s_value, abs(b));
+        g = gx;
+        s = a.sign ? -s_value : s_value;
+        t = b.sign ? -t_value : t_value;
+        return;
+    }
 
-    return big_integer(ans, a.sign ^ b.sign);
+    // Euclid on |x| >= |y| tracking only the cofactor of x, with Lehmer steps applied to both the
+    // remainders and the cofactors; the cofactor of y is recovered by one exact division at the end
+    bool swapped = cmp_abs(a, b) < 0;
+    big_integer const& x_value = swapped ? b : a;
+    big_integer const& y_value = swapped ? a : b;
+    size_t n = x_value.size();
+    // cofactors stay below |y| / gcd, plus the limb a matrix application may need
+    size_t cn = y_value.size() + 2;
+    limb_vector buffer;
+    buffer.resize_uninitialized(6 * n + 1 + 5 * cn);
+    uint32_t* x = buffer.mutable_data();
+    uint32_t* y = x + n;
+    uint32_t* u = y + n;
+    uint32_t* v = u + n;
+    uint32_t* q = v + n;
+    uint32_t* sx = q + n + 1;
+    uint32_t* sy = sx + cn;
+    uint32_t* su = sy + cn;
+    uint32_t* sv = su + cn;
+    uint32_t* product = sv + cn;
+
+    std::copy(x_value.number.cbegin(), x_value.number.cend(), x);
+    std::copy(y_value.number.cbegin(), y_value.number.cend(), y);
+    size_t xn = n, yn = y_value.size();
+    // both cofactor magnitudes are zero-padded to sn limbs; their signs alternate, x's is x_negative
+    sx[0] = 1;
+    sy[0] = 0;
+    size_t sn = 1;
+    bool x_negative = false;
+
+    while (yn != 0)
+    {
+        mpn::lehmer_matrix m;
+        if (mpn::lehmer(m, x, xn, y, yn))
+        {
+            std::fill(y + yn, y + xn, 0);
+            mpn::lehmer_reduce(u, v, m, x, y, xn);
+            mpn::lehmer_cofactors(su, sv, m, sx, sy, sn);
+            sn = std::max(mpn::normalized_size(su, sn + 1), mpn::normalized_size(sv, sn + 1));
+            x_negative ^= m.odd;
+            std::swap(sx, su);
+            std::swap(sy, sv);
+            std::swap(x, u);
+            std::swap(y, v);
+            yn = mpn::normalized_size(y, xn);
+            xn = mpn::normalized_size(x, xn);
+        }
+        else
+        {
+            size_t qn = xn - yn + 1;
+            if (yn == 1)
+                u[0] = mpn::divrem_1(q, x, xn, y[0]);
+            else
+                mpn::tdiv_qr(q, u, x, xn, y, yn);
+            qn = mpn::normalized_size(q, qn);
+
+            // the next cofactor is sx + q * sy in magnitude
+            size_t syn = mpn::normalized_size(sy, sn);
+            std::copy(sx, sx + sn, sv);
+            std::fill(sv + sn, sv + cn, 0);
+            if (syn != 0)
+            {
+                if (qn >= syn)
+                    mpn::mul(product, q, qn, sy, syn);
+                else
+                    mpn::mul(product, sy, syn, q, qn);
+                size_t pn = mpn::normalized_size(product, qn + syn);
+                size_t vn = std::max(sn, pn);
+                sv[vn] = mpn::add(sv, sv, vn, product, pn);
+                size_t new_sn = mpn::normalized_size(sv, vn + 1);
+                std::fill(sy + sn, sy + std::max(sn, new_sn), 0);
+                sn = std::max(sn, new_sn);
+            }
+            std::swap(sx, sy);
+            std::swap(sy, sv);
+            x_negative = !x_negative;
+            std::swap(x, y);
+            std::swap(y, u);
+            xn = yn;
+            yn = mpn::normalized_size(y, xn);
+        }
+    }
+
+    limb_vector g_limbs, s_limbs;
+    g_limbs.assign(x, x + xn);
+    s_limbs.assign(sx, sx + std::max<size_t>(sn, 1));
+    big_integer gx(g_limbs), sx_value(s_limbs);
+    if (x_negative)
+        sx_value = -sx_value;
+    big_integer abs_x = abs(x_value), abs_y = abs(y_value);
+    big_integer ty_value = divexact(gx - abs_x * sx_value, abs_y);
+    if (x_value.sign)
+        sx_value = -sx_value;
+    if (y_value.sign)
+        ty_value = -ty_value;
+
+    g = gx;
+    s = swapped ? ty_value : sx_value;
+    t = swapped ? sx_value : ty_value;
+}
+
+namespace
+{
+    // r^k <= x, without overflow
+    bool power_at_most(uint64_t r, unsigned k, uint64_t x)
+    {
+        uint64_t p = 1;
+        for (unsigned i = 0; i < k; ++i)
+        {
+            if (r != 0 && p > x / r)
+                return false;
+            p *= r;
+        }
+        return true;
+    }
+
+    // floor(x^(1/k)) of a word: the floating-point estimate is off by at most a few units
+    uint64_t root_word(uint64_t x, unsigned k)
+    {
+        if (k == 1)
+            return x;
+        auto r = static_cast<uint64_t>(std::pow(static_cast<double>(x), 1.0 / k));
+        while (r > 0 && !power_at_most(r, k, x))
+            --r;
+        while (power_at_most(r + 1, k, x))
+            ++r;
+        return r;
+    }
+
+    // floor(a^(1/k)) for a >= 0. The root of the leading bits, rounded up and shifted into place, is an
+    // over-estimate with about half of the bits right, so one step of Newton's iteration from above
+    // nearly always lands on the root; down to a word the recursion ends in a floating-point root.
+    big_integer root_floor(big_integer const& a, unsigned k)
+    {
+        size_t bits = a.bit_length();
+        if (bits <= 64)
+            return root_word(a.to_uint64(), k);
+        size_t root_bits = (bits - 1) / k + 1;
+        if (root_bits == 1)
+            return 1;
+
+        size_t h = root_bits / 2;
+        big_integer x = (root_floor(a >> static_cast<int>(k * h), k) + 1) << static_cast<int>(h);
+        big_integer power = pow(x, k - 1);
+        while (true)
+        {
+            // from above, the step never goes below the root and stops decreasing once it is there
+            big_integer y = (x * (k - 1) + a / power) / k;
+            if (y >= x)
+                return x;
+            x = y;
+            // x^(k-1) serves both this check and the next step
+            power = pow(x, k - 1);
+            if (power * x <= a)
+                return x;
+        }
+    }
+
+    // bit r is set when r is a square modulo m, m <= 64
+    uint64_t square_residues(uint32_t m)
+    {
+        uint64_t mask = 0;
+        for (uint32_t i = 0; i < m; ++i)
+            mask |= static_cast<uint64_t>(1) << (i * i % m);
+        return mask;
+    }
+}
+
+void sqrtrem(big_integer& s, big_integer& r, big_integer const& a)
+{
+    rootrem(s, r, a, 2);
+}
+
+big_integer isqrt(big_integer const& a)
+{
+    return root_floor(a, 2);
+}
+
+void rootrem(big_integer& root, big_integer& rem, big_integer const& a, unsigned k)
+{
+    big_integer x = root_floor(abs(a), k);
+    if (a.sgn() < 0)
+        x = -x;
+    rem = a - pow(x, k);
+    root = x;
+}
+
+big_integer iroot(big_integer const& a, unsigned k)
+{
+    big_integer x = root_floor(abs(a), k);
+    return a.sgn() < 0 ? -x : x;
+}
+
+bool is_perfect_square(big_integer const& a)
+{
+    if (a.sgn() <= 0)
+        return a.is_zero();
+
+    // squares are 0, 1, 4, 9, 16, 17, 25, 33, 36, 41, 49 or 57 modulo 64, and a single remainder
+    // modulo 63 * 65 * 11 covers four more moduli; together only about 1 in 100 non-squares get past
+    static const uint64_t residues_64 = square_residues(64);
+    static const uint64_t residues_63 = square_residues(63);
+    static const uint64_t residues_5 = square_residues(5);
+    static const uint64_t residues_13 = square_residues(13);
+    static const uint64_t residues_11 = square_residues(11);
+    if (!((residues_64 >> (a.to_uint64() & 63u)) & 1u))
+        return false;
+    uint64_t r = (a % 45045u).to_uint64();
+    if (!((residues_63 >> r % 63) & 1u) || !((residues_5 >> r % 5) & 1u) || !((residues_13 >> r % 13) & 1u) ||
+        !((residues_11 >> r % 11) & 1u))
+        return false;
+
+    big_integer x = root_floor(a, 2);
+    return x * x == a;
+}
+
+big_integer operator/(big_integer a, big_integer const &b) {
+    if (a.size() <= 2 && b.size() <= 2)
+        return big_integer::from_magnitude(a.low_magnitude() / b.low_magnitude(), a.sign ^ b.sign);
+
+    big_integer::divide(a, b, &a, nullptr);
+    return a;
 }
 
 big_integer operator%(big_integer a, big_integer const &b)
 {
-    return a - b * (a / b);
+    if (a.size() <= 2 && b.size() <= 2)
+        return big_integer::from_magnitude(a.low_magnitude() % b.low_magnitude(), a.sign);
+
+    big_integer::divide(a, b, nullptr, &a);
+    return a;
 }
 
 big_integer& big_integer::operator/=(big_integer const &rhs)
@@ -459,19 +1499,23 @@ big_integer big_integer::operator--(int)
     return tmp;
 }
 
-bool operator==(big_integer const &a, big_integer const &b)
+int cmp_abs(big_integer const& a, big_integer const& b)
 {
-    if (a.first_non_zero_index == SIZE_MAX &&
-            b.first_non_zero_index == SIZE_MAX)
-        return true;
+    return mpn::cmp(a.number.cbegin(), a.size(), b.number.cbegin(), b.size());
+}
 
-    if ((a.sign ^ b.sign) || a.size() != b.size())
-        return false;
+int compare(big_integer const& a, big_integer const& b)
+{
+    // zero is never negative, so differing signs decide on their own
+    if (a.sign != b.sign)
+        return a.sign ? -1 : 1;
+    int result = cmp_abs(a, b);
+    return a.sign ? -result : result;
+}
 
-    for (size_t i = 0; i < a.size(); i++)
-        if (a.number[i] != b.number[i])
-            return false;
-    return true;
+bool operator==(big_integer const &a, big_integer const &b)
+{
+    return a.sign == b.sign && a.size() == b.size() && mpn::cmp(a.number.cbegin(), b.number.cbegin(), a.size()) == 0;
 }
 
 bool operator!=(big_integer const &a, big_integer const &b)
@@ -481,63 +1525,53 @@ bool operator!=(big_integer const &a, big_integer const &b)
 
 bool operator<(big_integer const &a, big_integer const &b)
 {
-    if (a.sign && !b.sign)
-        return true;
-    if (!a.sign && b.sign)
-        return false;
-
-    if (a.size() < b.size())
-        return !a.sign;
-    if (a.size() > b.size())
-        return a.sign;
-
-    for (size_t i = a.size() - 1; i > 0; i--)
-    {
-        if (a.number[i] > b.number[i])
-            return a.sign;
-        if (a.number[i] < b.number[i])
-            return !a.sign;
-    }
-
-    if (a.number[0] > b.number[0])
-        return a.sign;
-    if (a.number[0] < b.number[0])
-        return !a.sign;
-    return false;
+    return compare(a, b) < 0;
 }
 
 bool operator<=(big_integer const &a, big_integer const &b)
 {
-    return (a < b) || (a == b);
+    return compare(a, b) <= 0;
 }
 
 bool operator>(big_integer const &a, big_integer const &b)
 {
-    return b < a;
+    return compare(a, b) > 0;
 }
 
 bool operator>=(big_integer const &a, big_integer const &b)
 {
-    return b <= a;
+    return compare(a, b) >= 0;
+}
+
+#if __cplusplus >= 202002L
+std::strong_ordering operator<=>(big_integer const& a, big_integer const& b)
+{
+    return compare(a, b) <=> 0;
 }
+#endif
 
 std::string to_string(big_integer const& a)
 {
-    if (a == 0)
+    if (a.is_zero())
         return "0";
 
-    bool sign = a.sign;
-    big_integer x = a;
-    x.sign = false;
+    static const uint32_t CHUNK = 1000000000;
+    static const size_t CHUNK_DIGITS = 9;
+
+    limb_vector tmp(a.number);
+    uint32_t* d = tmp.mutable_data();
+    size_t n = a.size();
     std::string result;
 
-    while (x > 0)
+    while (n > 0)
     {
-        std::pair <big_integer, uint32_t> tmp = x.divide_by_short(10);
-        x = tmp.first;
-        result += static_cast<char>(tmp.second) + '0';
+        uint32_t rem = mpn::divrem_1(d, d, n, CHUNK);
+        n = mpn::normalized_size(d, n);
+        // inner chunks keep their leading zeros
+        for (size_t k = 0; k < CHUNK_DIGITS && (n > 0 || rem > 0); ++k, rem /= 10)
+            result += static_cast<char>('0' + rem % 10);
     }
-    if (sign)
+    if (a.sign)
         result += '-';
     std::reverse(result.begin(), result.end());
     return result;
@@ -552,45 +1586,63 @@ std::ostream& operator<<(std::ostream& s, big_integer const& a)
 
 big_integer operator&(big_integer a, big_integer const& b)
 {
-    optimized_vector result;
-    for (size_t i = 0; i <= std::max(a.size(), b.size()); ++i)
+    if (a.size() <= 2 && b.size() <= 2)
     {
-        result.push_back(a.digit_in_twos_complement(i) &
-                         b.digit_in_twos_complement(i));
+        uint64_t low = a.low_twos_complement() & b.low_twos_complement();
+        bool negative = (a.sign & b.sign);
+        if (!negative || low)
+            return big_integer::from_twos_complement(low, negative);
     }
-    bool ans_sign = false;
-    if (result.back() > 0)
-        ans_sign = true;
+
+    size_t len = std::max(a.size(), b.size()) + 1;
+    limb_vector result;
+    result.resize_uninitialized(len);
+    uint32_t* r = result.mutable_data();
+    for (size_t i = 0; i < len; ++i)
+        r[i] = a.digit_in_twos_complement(i) & b.digit_in_twos_complement(i);
+    bool ans_sign = r[len - 1] > 0;
     return big_integer(result, ans_sign, true);
 }
 
 
 big_integer operator^(big_integer a, big_integer const& b)
 {
-    optimized_vector result;
-    for (size_t i = 0; i <= std::max(a.size(), b.size()); ++i)
+    if (a.size() <= 2 && b.size() <= 2)
     {
-        result.push_back(a.digit_in_twos_complement(i) ^
-                         b.digit_in_twos_complement(i));
+        uint64_t low = a.low_twos_complement() ^ b.low_twos_complement();
+        bool negative = (a.sign ^ b.sign);
+        if (!negative || low)
+            return big_integer::from_twos_complement(low, negative);
     }
-    bool ans_sign = false;
-    if (result.back() > 0)
-        ans_sign = true;
+
+    size_t len = std::max(a.size(), b.size()) + 1;
+    limb_vector result;
+    result.resize_uninitialized(len);
+    uint32_t* r = result.mutable_data();
+    for (size_t i = 0; i < len; ++i)
+        r[i] = a.digit_in_twos_complement(i) ^ b.digit_in_twos_complement(i);
+    bool ans_sign = r[len - 1] > 0;
     return big_integer(result, ans_sign, true);
 }
 
 
 big_integer operator|(big_integer a, big_integer const& b)
 {
-    optimized_vector result;
-    for (size_t i = 0; i <= std::max(a.size(), b.size()); ++i)
+    if (a.size() <= 2 && b.size() <= 2)
     {
-        result.push_back(a.digit_in_twos_complement(i) |
-                         b.digit_in_twos_complement(i));
+        uint64_t low = a.low_twos_complement() | b.low_twos_complement();
+        bool negative = (a.sign | b.sign);
+        if (!negative || low)
+            return big_integer::from_twos_complement(low, negative);
     }
-    bool ans_sign = false;
-    if (result.back() > 0)
-        ans_sign = true;
+
+    size_t len = std::max(a.size(), b.size()) + 1;
+    limb_vector result;
+    result.resize_uninitialized(len);
+    uint32_t* r = result.mutable_data();
+    for (size_t i = 0; i < len; ++i)
+        r[i] = a.digit_in_twos_complement(i) | b.digit_in_twos_complement(i);
+    bool ans_sign = r[len - 1] > 0;
     return big_integer(result, ans_sign, true);
 }
 
@@ -613,58 +1665,36 @@ big_integer& big_integer::operator^=(big_integer const& rhs)
 
 big_integer big_integer::operator~() const
 {
-    optimized_vector result;
-    for (size_t i = 0; i < this->size(); ++i)
-    {
-        result.push_back(~(this->digit_in_twos_complement(i)));
-    }
-    bool ans_sign = false;
-    if (!(this->number.back() & (1u << (LOG_BASE - 1))))
-        ans_sign = true;
-    return big_integer(result, ans_sign, true);
+    // ~x == -x - 1; flipping the limbs in place would lose the sign when the top bit is set
+    big_integer result(-*this);
+    result -= 1;
+    return result;
 }
 
 
-void emplace_shl(optimized_vector const &src, int b, optimized_vector &dest)
+void emplace_shl(limb_vector const &src, int b, limb_vector &dest)
 {
-    //dest = src;
-    dest.resize(src.size());
-    std::copy(src.begin(), src.end(), dest.begin());
-    std::reverse(dest.begin(), dest.end());
-    while (static_cast<uint32_t>(b) >= big_integer::LOG_BASE)
-    {
-        dest.push_back(0);
-        b -= big_integer::LOG_BASE;
-    }
-    std::reverse(dest.begin(), dest.end());
-    if (b > 0)
+    size_t limbs = static_cast<size_t>(b) / big_integer::LOG_BASE;
+    auto bits = static_cast<unsigned>(b) % big_integer::LOG_BASE;
+    size_t n = src.size();
+
+    limb_vector result;
+    result.resize_uninitialized(n + limbs + 1);
+    uint32_t* r = result.mutable_data();
+    std::fill(r, r + limbs, 0);
+    if (bits)
+        r[n + limbs] = mpn::lshift(r + limbs, src.cbegin(), n, bits);
+    else
     {
-        // b in [1..31]
-        dest.push_back(0);
-        for (size_t bit = big_integer::LOG_BASE * dest.size() - 1; bit > 0; bit--)
-        {
-            size_t next_bit;
-
-            dest[bit / big_integer::LOG_BASE] &= ~(1u << (bit % big_integer::LOG_BASE));
-
-            if (bit >= static_cast<size_t>(b))
-            {
-                next_bit = bit - static_cast<size_t>(b);
-
-                if (dest[next_bit / big_integer::LOG_BASE] & (1u << (next_bit % big_integer::LOG_BASE)))
-                {
-                    dest[bit / big_integer::LOG_BASE] |= (1u << (bit % big_integer::LOG_BASE));
-                }
-            }
-        }
-
-        dest[0] &= ~(1u);
+        std::copy(src.cbegin(), src.cend(), r + limbs);
+        r[n + limbs] = 0;
     }
+    dest.swap(result);
 }
 
 big_integer operator<<(big_integer a, int b)
 {
-    optimized_vector tmp;
+    limb_vector tmp;
     emplace_shl(a.number, b, tmp);
     return big_integer(tmp, a.sign);
 }
@@ -676,42 +1706,74 @@ big_integer& big_integer::operator<<=(int rhs)
     return *this;
 }
 
-void emplace_shr(optimized_vector const &src, int b, optimized_vector &dest)
+big_integer big_integer::shift_quotient(big_integer const& a, size_t n, bool round_away)
+{
+    size_t limbs = n / LOG_BASE;
+    auto bits = static_cast<unsigned>(n % LOG_BASE);
+    // the bits shifted out are non-zero iff the lowest non-zero limb is below the cut or holds some of them
+    bool inexact = a.first_non_zero_index < limbs ||
+                   (a.first_non_zero_index == limbs && (a.number[limbs] & ((1u << bits) - 1)));
+    bool increment = round_away && inexact;
+
+    if (limbs >= a.size())
+        return from_magnitude(increment ? 1 : 0, a.sign);
+
+    size_t qn = a.size() - limbs;
+    limb_vector q;
+    q.resize_uninitialized(qn + 1);
+    uint32_t* d = q.mutable_data();
+    if (bits)
+        mpn::rshift(d, a.number.cbegin() + limbs, qn, bits);
+    else
+        std::copy(a.number.cbegin() + limbs, a.number.cend(), d);
+    d[qn] = increment ? mpn::add_1(d, d, qn, 1) : 0;
+    return big_integer(q, a.sign);
+}
+
+big_integer tdiv_q_2exp(big_integer const& a, size_t n)
 {
-    dest.resize(src.size() - b / big_integer::LOG_BASE);
-    b %= big_integer::LOG_BASE;
+    return big_integer::shift_quotient(a, n, false);
+}
 
-    if (b > 0)
-    {
-        dest.push_back(0);
-        for (size_t i = 0; i < dest.size() - 1; i++)
-        {
-            uint64_t tmp = (static_cast<uint64_t>((i + 1 < src.size() ? src[i + 1] : 0)) << (big_integer::LOG_BASE))
-                           ^ static_cast<uint64_t>(src[i]);
-            tmp >>= b;
-            dest[i] = static_cast<uint32_t>(tmp & UINT32_MAX);
-            dest[i + 1] &= ~((1u << b) - 1);
-            dest[i + 1] |= static_cast<uint32_t>(tmp >> big_integer::LOG_BASE);
-        }
-    }
+big_integer fdiv_q_2exp(big_integer const& a, size_t n)
+{
+    return big_integer::shift_quotient(a, n, a.sign);
+}
+
+big_integer cdiv_q_2exp(big_integer const& a, size_t n)
+{
+    return big_integer::shift_quotient(a, n, !a.sign);
+}
+
+big_integer tdiv_r_2exp(big_integer const& a, size_t n)
+{
+    big_integer result(a);
+    result.truncate_to_bits(n);
+    return result;
+}
+
+big_integer fdiv_r_2exp(big_integer const& a, size_t n)
+{
+    big_integer result(a);
+    result.mod_2exp(n);
+    return result;
+}
+
+big_integer cdiv_r_2exp(big_integer const& a, size_t n)
+{
+    // a - 2^n * ceil(a / 2^n) == -(-a mod 2^n)
+    big_integer result(-a);
+    result.mod_2exp(n);
+    return -result;
 }
 
 big_integer operator>>(big_integer a, int b)
 {
-    optimized_vector res;
-    emplace_shr(a.number, b, res);
-    big_integer tmp(res, a.sign);
-    if (a.sign)
-        tmp -= 1;
-    tmp.normalize();
-    return tmp;
+    // arithmetic shift rounds towards minus infinity
+    return fdiv_q_2exp(a, static_cast<size_t>(b));
 }
 
 big_integer& big_integer::operator>>=(int rhs)
 {
-    emplace_shr(this->number, rhs, this->number);
-    if (this->sign)
-        *this -= 1;
-    this->normalize();
-    return *this;
-}
\ No newline at end of file
+    return *this = fdiv_q_2exp(*this, static_cast<size_t>(rhs));
+}
@@ -7,6 +7,29 @@
 #include <cstdint>
 #include <string>
 #include <ostream>
+#include <type_traits>
+#if __cplusplus >= 202002L
+#include <compare>
+#endif
+
+// limbs stored inline before big_integer goes to the heap;
+// the default covers values up to 512 bits without allocation
+#ifndef BIG_INTEGER_INLINE_LIMBS
+#define BIG_INTEGER_INLINE_LIMBS 16
+#endif
+
+typedef basic_optimized_vector<BIG_INTEGER_INLINE_LIMBS> limb_vector;
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+#endif
+
+// R, when T is a built-in integer type of at most 64 bits (mixed big_integer/integer operators); the GNU
+// dialects count __int128 as integral, and it goes through the int128_t/uint128_t constructors instead
+template <typename T, typename R>
+using enable_if_integral =
+        typename std::enable_if<std::is_integral<T>::value && sizeof(T) <= sizeof(uint64_t), R>::type;
 
 class big_integer
 {
@@ -14,25 +37,70 @@ class big_integer
     static const uint32_t LOG_BASE = 32u;
 
     bool sign;
-    optimized_vector number;
+    limb_vector number;
     size_t first_non_zero_index;
     bool is_two_complemented;
 
-    explicit big_integer(optimized_vector const& number, bool sign = false, bool two_complemented = false);
-    explicit big_integer(uint32_t x);
+    explicit big_integer(limb_vector const& number, bool sign = false, bool two_complemented = false);
 
     size_t size() const;
     void normalize();
 
-    std::pair<big_integer, uint32_t> divide_by_short(uint32_t x, bool sign=false);
+    static big_integer add_magnitudes(big_integer const& a, big_integer const& b, bool sign);
+    // |a| - |b|, negated when sign is set
+    static big_integer sub_magnitudes(big_integer const& a, big_integer const& b, bool sign);
+    enum rounding { TRUNCATE, FLOOR, CEIL, EUCLID };
+    static bool rounds_away(rounding mode, bool a_sign, bool b_sign);
+    static bool adjusted_remainder_sign(rounding mode, bool b_sign);
+    // division rounding the quotient as given by mode, either output may be null or alias an input
+    static void divide(big_integer const& a, big_integer const& b, big_integer* quotient, big_integer* remainder,
+                       rounding mode = TRUNCATE);
+    // |a| >> n with the sign of a, one further from zero when round_away is set and bits were lost
+    static big_integer shift_quotient(big_integer const& a, size_t n, bool round_away);
 
     uint32_t digit_in_abs_format(size_t n) const;
     uint32_t digit_in_twos_complement(size_t n) const;
 
+    enum bit_operation { SET_BIT, CLEAR_BIT, FLIP_BIT };
+    // applies op to bit n of the magnitude, without normalizing
+    void change_magnitude_bit(size_t n, bit_operation op);
+    void change_bit(size_t n, bit_operation op);
+
+    // fast paths for values of at most two limbs
+    uint64_t low_magnitude() const;
+    uint64_t low_twos_complement() const;
+    static big_integer from_magnitude(uint64_t magnitude, bool sign);
+    static big_integer from_twos_complement(uint64_t low, bool negative);
+    void assign_magnitude(uint64_t magnitude, bool sign);
+
+    // in-place kernels for a machine-word operand given as magnitude and sign
+    template <typename T>
+    static uint64_t word_magnitude(T a);
+    template <typename T>
+    static bool word_is_negative(T a);
+
+    void add_word(uint64_t magnitude, bool negative);
+    void mul_word(uint64_t magnitude, bool negative);
+    void div_word(uint64_t magnitude, bool negative);
+    uint64_t mod_word(uint64_t magnitude) const;
+    int compare_word(uint64_t magnitude, bool negative) const;
+
+    // *this += a * b (or -= when negative is set) in this object's own buffer
+    void add_product(big_integer const& a, big_integer const& b, bool negative);
+
+    friend class big_expr_evaluator;
+    friend class montgomery_context;
+    friend class barrett_reducer;
+
 public:
     big_integer();
     big_integer(big_integer const& other);
-    big_integer(int a);
+    template <typename T, typename = enable_if_integral<T, void>>
+    big_integer(T a);
+#ifdef __SIZEOF_INT128__
+    big_integer(int128_t a);
+    big_integer(uint128_t a);
+#endif
     explicit big_integer(std::string const& str);
     ~big_integer() = default;
 
@@ -50,6 +118,17 @@ public:
     big_integer& operator/=(big_integer const& rhs);
     big_integer& operator%=(big_integer const& rhs);
 
+    template <typename T>
+    enable_if_integral<T, big_integer&> operator+=(T rhs);
+    template <typename T>
+    enable_if_integral<T, big_integer&> operator-=(T rhs);
+    template <typename T>
+    enable_if_integral<T, big_integer&> operator*=(T rhs);
+    template <typename T>
+    enable_if_integral<T, big_integer&> operator/=(T rhs);
+    template <typename T>
+    enable_if_integral<T, big_integer&> operator%=(T rhs);
+
     friend big_integer operator&(big_integer a, big_integer const& b);
     friend big_integer operator|(big_integer a, big_integer const& b);
     friend big_integer operator^(big_integer a, big_integer const& b);
@@ -80,17 +159,272 @@ public:
     friend bool operator>(big_integer const& a, big_integer const& b);
     friend bool operator<=(big_integer const& a, big_integer const& b);
     friend bool operator>=(big_integer const& a, big_integer const& b);
+#if __cplusplus >= 202002L
+    friend std::strong_ordering operator<=>(big_integer const& a, big_integer const& b);
+#endif
 
-    friend void emplace_shl(optimized_vector const &src, int b, optimized_vector &dest);
-    friend void emplace_shr(optimized_vector const &src, int b, optimized_vector &dest);
+    friend int cmp_abs(big_integer const& a, big_integer const& b);
+    friend int compare(big_integer const& a, big_integer const& b);
+
+    template <typename T>
+    friend enable_if_integral<T, bool> operator==(big_integer const& a, T b);
+    template <typename T>
+    friend enable_if_integral<T, bool> operator<(big_integer const& a, T b);
+    template <typename T>
+    friend enable_if_integral<T, bool> operator>(big_integer const& a, T b);
+#if __cplusplus >= 202002L
+    template <typename T>
+    friend enable_if_integral<T, std::strong_ordering> operator<=>(big_integer const& a, T b);
+#endif
+
+    // queries without temporaries; bit_length and popcount are of the magnitude,
+    // test_bit sees negative values in two's complement like the bitwise operators
+    bool is_zero() const;
+    int sgn() const;
+    size_t bit_length() const;
+    size_t popcount() const;
+    // 0 for zero
+    size_t count_trailing_zeros() const;
+    bool test_bit(size_t n) const;
+
+    // in-place bit updates, in two's complement like test_bit; storage grows as needed
+    void set_bit(size_t n);
+    void clear_bit(size_t n);
+    void flip_bit(size_t n);
+    // keeps the low n bits of the magnitude and the sign (the remainder of truncating division by 2^n)
+    void truncate_to_bits(size_t n);
+    // reduces to [0, 2^n) (the remainder of floor division by 2^n)
+    void mod_2exp(size_t n);
+
+    // conversions wrap modulo 2^64 (2^128) when the value doesn't fit
+    bool fits_int64() const;
+    bool fits_uint64() const;
+    int64_t to_int64() const;
+    uint64_t to_uint64() const;
+#ifdef __SIZEOF_INT128__
+    bool fits_int128() const;
+    bool fits_uint128() const;
+    int128_t to_int128() const;
+    uint128_t to_uint128() const;
+#endif
+
+    friend void emplace_shl(limb_vector const &src, int b, limb_vector &dest);
 
     friend std::string to_string(big_integer const& a);
     friend big_integer from_string(std::string const& str);
     friend big_integer abs(big_integer const& x);
 
+    friend big_integer tdiv_q_2exp(big_integer const& a, size_t n);
+    friend big_integer fdiv_q_2exp(big_integer const& a, size_t n);
+    friend big_integer cdiv_q_2exp(big_integer const& a, size_t n);
+
+    friend void tdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+    friend void fdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+    friend void cdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+    friend void ediv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+    friend big_integer divexact(big_integer const& a, big_integer const& b);
+    friend big_integer pow(big_integer const& base, uint64_t exp);
+    friend big_integer gcd(big_integer const& a, big_integer const& b);
+    friend big_integer lcm(big_integer const& a, big_integer const& b);
+    friend void gcdext(big_integer& g, big_integer& s, big_integer& t, big_integer const& a, big_integer const& b);
+    friend big_integer& addmul(big_integer& acc, big_integer const& a, big_integer const& b);
+    friend big_integer& submul(big_integer& acc, big_integer const& a, big_integer const& b);
+
     void swap(big_integer &other);
 };
 
+template <typename T, typename>
+big_integer::big_integer(T a) : big_integer()
+{
+    assign_magnitude(word_magnitude(a), word_is_negative(a));
+}
+
+template <typename T>
+uint64_t big_integer::word_magnitude(T a)
+{
+    return word_is_negative(a) ? ~static_cast<uint64_t>(a) + 1 : static_cast<uint64_t>(a);
+}
+
+template <typename T>
+bool big_integer::word_is_negative(T a)
+{
+    return std::is_signed<T>::value && a < T(0);
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator+=(T rhs)
+{
+    add_word(word_magnitude(rhs), word_is_negative(rhs));
+    return *this;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator-=(T rhs)
+{
+    add_word(word_magnitude(rhs), !word_is_negative(rhs));
+    return *this;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator*=(T rhs)
+{
+    mul_word(word_magnitude(rhs), word_is_negative(rhs));
+    return *this;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator/=(T rhs)
+{
+    div_word(word_magnitude(rhs), word_is_negative(rhs));
+    return *this;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator%=(T rhs)
+{
+    return *this = from_magnitude(mod_word(word_magnitude(rhs)), sign);
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator+(big_integer a, T b)
+{
+    return a += b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator+(T a, big_integer b)
+{
+    return b += a;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator-(big_integer a, T b)
+{
+    return a -= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator-(T a, big_integer const& b)
+{
+    return big_integer(a) - b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator*(big_integer a, T b)
+{
+    return a *= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator*(T a, big_integer b)
+{
+    return b *= a;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator/(big_integer a, T b)
+{
+    return a /= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator/(T a, big_integer const& b)
+{
+    return big_integer(a) / b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator%(big_integer a, T b)
+{
+    return a %= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator%(T a, big_integer const& b)
+{
+    return big_integer(a) % b;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator==(big_integer const& a, T b)
+{
+    return a.compare_word(big_integer::word_magnitude(b), big_integer::word_is_negative(b)) == 0;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator<(big_integer const& a, T b)
+{
+    return a.compare_word(big_integer::word_magnitude(b), big_integer::word_is_negative(b)) < 0;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator>(big_integer const& a, T b)
+{
+    return a.compare_word(big_integer::word_magnitude(b), big_integer::word_is_negative(b)) > 0;
+}
+
+#if __cplusplus >= 202002L
+template <typename T>
+enable_if_integral<T, std::strong_ordering> operator<=>(big_integer const& a, T b)
+{
+    return a.compare_word(big_integer::word_magnitude(b), big_integer::word_is_negative(b)) <=> 0;
+}
+#endif
+
+template <typename T>
+enable_if_integral<T, bool> operator!=(big_integer const& a, T b)
+{
+    return !(a == b);
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator<=(big_integer const& a, T b)
+{
+    return !(a > b);
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator>=(big_integer const& a, T b)
+{
+    return !(a < b);
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator==(T a, big_integer const& b)
+{
+    return b == a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator!=(T a, big_integer const& b)
+{
+    return !(b == a);
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator<(T a, big_integer const& b)
+{
+    return b > a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator>(T a, big_integer const& b)
+{
+    return b < a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator<=(T a, big_integer const& b)
+{
+    return !(b < a);
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator>=(T a, big_integer const& b)
+{
+    return !(b > a);
+}
+
 big_integer operator+(big_integer a, big_integer const& b);
 big_integer operator-(big_integer a, big_integer const& b);
 big_integer operator*(big_integer a, big_integer const& b);
@@ -110,6 +444,13 @@ bool operator<(big_integer const& a, big_integer const& b);
 bool operator>(big_integer const& a, big_integer const& b);
 bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
+#if __cplusplus >= 202002L
+std::strong_ordering operator<=>(big_integer const& a, big_integer const& b);
+#endif
+
+// sign of |a| - |b| and of a - b: -1, 0 or 1, without copying either operand
+int cmp_abs(big_integer const& a, big_integer const& b);
+int compare(big_integer const& a, big_integer const& b);
 
 std::string to_string(big_integer const& a);
 big_integer from_string(std::string const& str);
@@ -117,4 +458,47 @@ std::ostream& operator<<(std::ostream& s, big_integer const& a);
 
 big_integer abs(big_integer const& x);
 
+// division by 2^n rounding towards zero (t), minus infinity (f) or plus infinity (c),
+// and the matching remainders a - q * 2^n
+big_integer tdiv_q_2exp(big_integer const& a, size_t n);
+big_integer fdiv_q_2exp(big_integer const& a, size_t n);
+big_integer cdiv_q_2exp(big_integer const& a, size_t n);
+big_integer tdiv_r_2exp(big_integer const& a, size_t n);
+big_integer fdiv_r_2exp(big_integer const& a, size_t n);
+big_integer cdiv_r_2exp(big_integer const& a, size_t n);
+
+// quotient and remainder of a / b with the quotient rounded towards zero (t), minus infinity (f),
+// plus infinity (c), or so that 0 <= r < |b| (e); q and r must be distinct objects
+void tdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+void fdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+void cdiv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+void ediv_qr(big_integer& q, big_integer& r, big_integer const& a, big_integer const& b);
+
+// a / b when b is known to divide a; the result is unspecified otherwise
+big_integer divexact(big_integer const& a, big_integer const& b);
+
+// base^exp; the result is allocated once, at its final size
+big_integer pow(big_integer const& base, uint64_t exp);
+
+// greatest common divisor and least common multiple, both non-negative; gcd(0, 0) == 0
+big_integer gcd(big_integer const& a, big_integer const& b);
+big_integer lcm(big_integer const& a, big_integer const& b);
+// g = gcd(a, b) and cofactors with g == a * s + b * t
+void gcdext(big_integer& g, big_integer& s, big_integer& t, big_integer const& a, big_integer const& b);
+
+// floor(sqrt(a)) and the remainder a - s^2 for a >= 0; s and r must be distinct objects
+void sqrtrem(big_integer& s, big_integer& r, big_integer const& a);
+big_integer isqrt(big_integer const& a);
+// the k-th root truncated towards zero and the remainder a - root^k for k >= 1, a >= 0 when k is even;
+// root and rem must be distinct objects
+void rootrem(big_integer& root, big_integer& rem, big_integer const& a, unsigned k);
+big_integer iroot(big_integer const& a, unsigned k);
+// whether a is the square of an integer; residues modulo small numbers reject most non-squares
+// before any root is taken
+bool is_perfect_square(big_integer const& a);
+
+// acc += a * b and acc -= a * b without a product temporary
+big_integer& addmul(big_integer& acc, big_integer const& a, big_integer const& b);
+big_integer& submul(big_integer& acc, big_integer const& a, big_integer const& b);
+
 #endif // BIG_INTEGER_H
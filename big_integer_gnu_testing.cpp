@@ -0,0 +1,83 @@
+#include <type_traits>
+#include <gtest/gtest.h>
+
+#include "big_integer.h"
+
+// Built with -std=gnu++11, where std::is_integral holds for __int128: the mixed operators must not take
+// such operands through their 64-bit paths and drop the high half.
+#ifdef __SIZEOF_INT128__
+static_assert(std::is_integral<int128_t>::value, "this test must be built in a GNU dialect");
+
+TEST(gnu_int128, compound_assignment)
+{
+    int128_t s = (static_cast<int128_t>(1) << 100) + 7;
+    uint128_t u = ~static_cast<uint128_t>(0) - 5;
+    big_integer bs = (big_integer(1) << 100) + 7;
+    big_integer bu = (big_integer(1) << 128) - 6;
+
+    big_integer a = 1;
+    a += s;
+    EXPECT_EQ(a, bs + 1);
+    a -= s;
+    EXPECT_EQ(a, 1);
+    a -= -s;
+    EXPECT_EQ(a, bs + 1);
+    a = 5;
+    a *= u;
+    EXPECT_EQ(a, bu * 5);
+    a = bu * 3 + 2;
+    a /= u;
+    EXPECT_EQ(a, 3);
+    a = bs * 3 + 2;
+    a %= s;
+    EXPECT_EQ(a, 2);
+    a = -(bs * 3 + 2);
+    a %= -s;
+    EXPECT_EQ(a, -2);
+}
+
+TEST(gnu_int128, arithmetic)
+{
+    int128_t s = -(static_cast<int128_t>(1) << 100) - 7;
+    uint128_t u = static_cast<uint128_t>(1) << 127;
+    big_integer bs = -(big_integer(1) << 100) - 7;
+    big_integer bu = big_integer(1) << 127;
+    big_integer x("123456789012345678901234567890123456789012345678901234567890");
+
+    EXPECT_EQ(x + s, x + bs);
+    EXPECT_EQ(s + x, x + bs);
+    EXPECT_EQ(x - u, x - bu);
+    EXPECT_EQ(u - x, bu - x);
+    EXPECT_EQ(big_integer(5) * u, bu * 5);
+    EXPECT_EQ(s * x, x * bs);
+    EXPECT_EQ(x / s, x / bs);
+    EXPECT_EQ(u / big_integer(3), bu / 3);
+    EXPECT_EQ(x % u, x % bu);
+    EXPECT_EQ(s % big_integer(1000), bs % 1000);
+}
+
+TEST(gnu_int128, comparison)
+{
+    int128_t s = static_cast<int128_t>(1) << 100;
+    uint128_t u = ~static_cast<uint128_t>(0);
+    big_integer bs = big_integer(1) << 100;
+    big_integer bu = (big_integer(1) << 128) - 1;
+
+    EXPECT_TRUE(bs == s);
+    EXPECT_TRUE(s == bs);
+    EXPECT_TRUE(bu == u);
+    EXPECT_FALSE(bs != s);
+    EXPECT_TRUE(u != bs);
+    EXPECT_TRUE(bs < u);
+    EXPECT_TRUE(s < bu);
+    EXPECT_TRUE(bu > s);
+    EXPECT_TRUE(u > bs);
+    EXPECT_TRUE(bs <= s);
+    EXPECT_TRUE(s <= bs);
+    EXPECT_TRUE(bu >= u);
+    EXPECT_TRUE(u >= bu);
+    EXPECT_FALSE(bs == s + 1);
+    EXPECT_TRUE(-bs == -s);
+    EXPECT_TRUE(-bs < 0);
+}
+#endif
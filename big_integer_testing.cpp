@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <limits>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
@@ -409,6 +410,16 @@ TEST(correctness, shl_)
     EXPECT_TRUE(a == 23 * 32);
 }
 
+TEST(correctness, shl_copy_is_independent)
+{
+    big_integer a("123456789012345678901234567890");
+    big_integer b = a;
+    a <<= 70;
+
+    EXPECT_EQ(b, big_integer("123456789012345678901234567890"));
+    EXPECT_EQ(a, b * big_integer("1180591620717411303424"));
+}
+
 TEST(correctness, shl_return_value)
 {
     big_integer a = 1;
@@ -444,6 +455,21 @@ TEST(correctness, shr_signed)
     EXPECT_EQ(a, -155);
 }
 
+TEST(correctness, shr_long)
+{
+    big_integer a("123456789012345678901234567890123456789");
+    big_integer pow70("1180591620717411303424");
+
+    EXPECT_EQ(a >> 70, a / pow70);
+    EXPECT_EQ(a >> 64, a / big_integer("18446744073709551616"));
+    EXPECT_EQ((a << 70) >> 70, a);
+    EXPECT_EQ(a >> 1000, 0);
+    EXPECT_EQ(-a >> 70, -(a / pow70) - 1);
+    EXPECT_EQ(-(a << 70) >> 70, -a);
+    EXPECT_EQ(big_integer(-8) >> 3, -1);
+    EXPECT_EQ(big_integer(-1) >> 1000, -1);
+}
+
 TEST(correctness, shr_return_value)
 {
     big_integer a = 64;
@@ -452,6 +478,136 @@ TEST(correctness, shr_return_value)
     EXPECT_EQ(a, 8);
 }
 
+TEST(correctness, two_limb_boundaries)
+{
+    big_integer max64("18446744073709551615");
+    big_integer pow64("18446744073709551616");
+
+    EXPECT_EQ(max64 + 1, pow64);
+    EXPECT_EQ(-max64 - 1, -pow64);
+    EXPECT_EQ(1 - -max64, pow64);
+    EXPECT_EQ(max64 - max64, 0);
+    EXPECT_EQ(big_integer(65536) * 65536 * 65536 * 65536, pow64);
+    EXPECT_EQ(max64 * -1, -max64);
+    EXPECT_EQ(max64 / big_integer("4294967296"), big_integer("4294967295"));
+    EXPECT_EQ(-max64 / 5, big_integer("-3689348814741910323"));
+    EXPECT_EQ(-max64 % 10, -5);
+    EXPECT_EQ(max64 % -10, 5);
+}
+
+TEST(correctness, two_limb_bitwise)
+{
+    big_integer max64("18446744073709551615");
+
+    EXPECT_EQ(-max64 & -1, -max64);
+    EXPECT_EQ(-max64 | max64, -1);
+    EXPECT_EQ(-max64 ^ max64, -2);
+    EXPECT_EQ(max64 ^ max64, 0);
+    EXPECT_EQ(big_integer(-2) & -max64, big_integer("-18446744073709551616"));
+}
+
+TEST(correctness, ctor_int64_limits)
+{
+    big_integer a = std::numeric_limits<int64_t>::min();
+    big_integer b = std::numeric_limits<int64_t>::max();
+    big_integer c = std::numeric_limits<uint64_t>::max();
+
+    EXPECT_EQ(to_string(a), "-9223372036854775808");
+    EXPECT_EQ(to_string(b), "9223372036854775807");
+    EXPECT_EQ(to_string(c), "18446744073709551615");
+    EXPECT_EQ(a + b, -1);
+    EXPECT_EQ(big_integer(0u), 0);
+    EXPECT_EQ(big_integer(static_cast<unsigned short>(7)), 7);
+}
+
+TEST(correctness, int64_conversions)
+{
+    big_integer a = std::numeric_limits<int64_t>::min();
+    big_integer b("18446744073709551615");
+
+    EXPECT_TRUE(a.fits_int64());
+    EXPECT_FALSE((a - 1).fits_int64());
+    EXPECT_FALSE(a.fits_uint64());
+    EXPECT_EQ(a.to_int64(), std::numeric_limits<int64_t>::min());
+    EXPECT_FALSE(b.fits_int64());
+    EXPECT_TRUE(b.fits_uint64());
+    EXPECT_EQ(b.to_uint64(), std::numeric_limits<uint64_t>::max());
+    EXPECT_FALSE((b + 1).fits_uint64());
+    EXPECT_EQ((b + 2).to_uint64(), 1u);
+    EXPECT_EQ(big_integer(-5).to_int64(), -5);
+}
+
+#ifdef __SIZEOF_INT128__
+TEST(correctness, int128)
+{
+    int128_t min128 = -static_cast<int128_t>(~static_cast<uint128_t>(0) >> 1) - 1;
+    big_integer a = min128;
+    big_integer b = ~static_cast<uint128_t>(0);
+
+    EXPECT_EQ(to_string(a), "-170141183460469231731687303715884105728");
+    EXPECT_EQ(to_string(b), "340282366920938463463374607431768211455");
+    EXPECT_TRUE(a.fits_int128());
+    EXPECT_FALSE((a - 1).fits_int128());
+    EXPECT_TRUE(a.to_int128() == min128);
+    EXPECT_TRUE(b.fits_uint128());
+    EXPECT_FALSE(b.fits_int128());
+    EXPECT_TRUE(b.to_uint128() == ~static_cast<uint128_t>(0));
+    EXPECT_EQ(big_integer(static_cast<int128_t>(-3)), -3);
+}
+#endif
+
+TEST(correctness, mixed_operators)
+{
+    big_integer a("100000000000000000000000000000");
+    uint64_t u = 12345678901234567890ull;
+    int64_t s = -9876543210123ll;
+
+    EXPECT_EQ(a + u, big_integer("100000000012345678901234567890"));
+    EXPECT_EQ(u + a, big_integer("100000000012345678901234567890"));
+    EXPECT_EQ(a - u, big_integer("99999999987654321098765432110"));
+    EXPECT_EQ(u - a, big_integer("-99999999987654321098765432110"));
+    EXPECT_EQ(a * s, big_integer("-987654321012300000000000000000000000000000"));
+    EXPECT_EQ(a / s, big_integer("-10124999999747343"));
+    EXPECT_EQ(a % s, big_integer("2777840046811"));
+    EXPECT_EQ(a % 7u, 5);
+    EXPECT_EQ(5 - big_integer(7), -2);
+    EXPECT_EQ(100 / big_integer(7), 14);
+    EXPECT_EQ(100 % big_integer(-7), 2);
+
+    EXPECT_TRUE(a > u);
+    EXPECT_TRUE(u < a);
+    EXPECT_TRUE(-a < s);
+    EXPECT_TRUE(big_integer(s) == s);
+    EXPECT_TRUE(s == big_integer(s));
+    EXPECT_TRUE(big_integer(u) != s);
+    EXPECT_TRUE(big_integer(0) >= 0u);
+    EXPECT_TRUE(-1 <= big_integer(0));
+}
+
+TEST(correctness, mixed_operators_randomized)
+{
+    for (size_t itn = 0; itn != 1000; ++itn)
+    {
+        big_integer a = 1;
+        for (int i = rand() % 6; i > 0; --i)
+            a = a * rand() + rand();
+        if (rand() % 2)
+            a = -a;
+        int64_t w = (static_cast<int64_t>(rand()) << (rand() % 33)) + 1;
+        if (rand() % 2)
+            w = -w;
+        big_integer bw = big_integer(std::to_string(w));
+
+        ASSERT_EQ(a + w, a + bw);
+        ASSERT_EQ(a - w, a - bw);
+        ASSERT_EQ(a * w, a * bw);
+        ASSERT_EQ(a / w, a / bw);
+        ASSERT_EQ(a % w, a % bw);
+        ASSERT_EQ(a < w, a < bw);
+        ASSERT_EQ(a == w, a == bw);
+    }
+}
+
 TEST(correctness, add_long)
 {
     big_integer a("10000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000");
@@ -712,3 +868,654 @@ TEST(correctness, div_randomized)
         EXPECT_LT(residue, divisor);
     }
 }
+
+TEST(correctness, div_mod_identity_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        big_integer a = rand_big(rand() % 20);
+        big_integer b = rand_big(rand() % 12) + 1;
+        big_integer r = rand_big(rand() % 12) % b;
+        if (rand() % 2)
+            a = -a;
+
+        big_integer x = a * b + (a < 0 ? -r : r);
+        ASSERT_EQ(x / b, a);
+        ASSERT_EQ(x % b, a < 0 ? -r : r);
+        ASSERT_EQ(x / -b, -a);
+    }
+}
+
+TEST(correctness, string_round_trip_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn)
+    {
+        std::string digits(1, static_cast<char>('1' + rand() % 9));
+        for (size_t i = rand() % 200; i > 0; --i)
+            digits += static_cast<char>('0' + rand() % 10);
+        if (rand() % 2)
+            digits = "-" + digits;
+
+        ASSERT_EQ(to_string(big_integer(digits)), digits);
+    }
+    EXPECT_EQ(to_string(big_integer("1000000000000000000")), "1000000000000000000");
+    EXPECT_EQ(to_string(big_integer("-000000000000000000001")), "-1");
+}
+
+TEST(correctness, addmul_submul)
+{
+    big_integer acc;
+    addmul(acc, big_integer(3), big_integer(4));
+    EXPECT_EQ(acc, 12);
+    submul(acc, big_integer(5), big_integer(4));
+    EXPECT_EQ(acc, -8);
+    addmul(acc, big_integer(-2), big_integer(-4));
+    EXPECT_EQ(acc, 0);
+    EXPECT_EQ(to_string(acc), "0");
+
+    big_integer a("123456789012345678901234567890");
+    big_integer b("-987654321098765432109876543210");
+    big_integer c = a;
+    addmul(c, a, b);
+    EXPECT_EQ(c, a + a * b);
+    submul(c, a, b);
+    EXPECT_EQ(c, a);
+    addmul(c, c, c);
+    EXPECT_EQ(c, a + a * a);
+    submul(c, a, big_integer(0));
+    EXPECT_EQ(c, a + a * a);
+}
+
+TEST(correctness, addmul_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        big_integer acc = rand_big(rand() % 20), a = rand_big(rand() % 12), b = rand_big(rand() % 12);
+        if (rand() % 2)
+            acc = -acc;
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 2)
+            b = -b;
+
+        big_integer expected = acc + a * b;
+        big_integer copy = acc;
+        ASSERT_EQ(addmul(acc, a, b), expected);
+        ASSERT_EQ(submul(acc, a, b), copy);
+    }
+}
+
+TEST(correctness, addmul_large)
+{
+    // operands past the Karatsuba threshold, where the kernels fold in a separately computed product
+    for (size_t itn = 0; itn != 20; ++itn)
+    {
+        big_integer acc = rand_big(rand() % 600), a = rand_big(60 + rand() % 300), b = rand_big(60 + rand() % 300);
+        if (rand() % 2)
+            acc = -acc;
+        if (rand() % 2)
+            b = -b;
+
+        big_integer expected = acc + a * b;
+        big_integer copy = acc;
+        ASSERT_EQ(addmul(acc, a, b), expected);
+        ASSERT_EQ(submul(acc, a, b), copy);
+    }
+}
+
+TEST(correctness, compare_three_way)
+{
+    big_integer a("123456789012345678901234567890");
+    big_integer b("-123456789012345678901234567891");
+
+    EXPECT_EQ(compare(a, a), 0);
+    EXPECT_EQ(compare(a, b), 1);
+    EXPECT_EQ(compare(b, a), -1);
+    EXPECT_EQ(compare(b, b - 1), 1);
+    EXPECT_EQ(compare(big_integer(), -big_integer()), 0);
+    EXPECT_EQ(compare(big_integer(-1), big_integer()), -1);
+
+    EXPECT_EQ(cmp_abs(a, b), -1);
+    EXPECT_EQ(cmp_abs(b, a), 1);
+    EXPECT_EQ(cmp_abs(a, -a), 0);
+    EXPECT_EQ(cmp_abs(big_integer(), big_integer(5)), -1);
+
+    EXPECT_TRUE(a <= a);
+    EXPECT_TRUE(b <= a);
+    EXPECT_FALSE(a <= b);
+    EXPECT_TRUE(a >= a);
+
+#if __cplusplus >= 202002L
+    EXPECT_TRUE((a <=> b) > 0);
+    EXPECT_TRUE((a <=> a) == 0);
+    EXPECT_TRUE((b <=> 0) < 0);
+#endif
+}
+
+TEST(correctness, compare_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        big_integer a = rand_big(rand() % 4), b = rand_big(rand() % 4);
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 2)
+            b = -b;
+        if (rand() % 4 == 0)
+            b = a;
+
+        int expected = (a - b < 0) ? -1 : ((a - b == 0) ? 0 : 1);
+        ASSERT_EQ(compare(a, b), expected);
+        ASSERT_EQ(compare(b, a), -expected);
+        ASSERT_EQ(cmp_abs(a, b), compare(abs(a), abs(b)));
+    }
+}
+
+TEST(correctness, bit_queries)
+{
+    big_integer zero;
+    EXPECT_TRUE(zero.is_zero());
+    EXPECT_EQ(zero.sgn(), 0);
+    EXPECT_EQ(zero.bit_length(), 0u);
+    EXPECT_EQ(zero.popcount(), 0u);
+    EXPECT_EQ(zero.count_trailing_zeros(), 0u);
+    EXPECT_FALSE(zero.test_bit(0));
+    EXPECT_TRUE((big_integer(5) - 5).is_zero());
+
+    big_integer a = big_integer(1) << 100;
+    EXPECT_FALSE(a.is_zero());
+    EXPECT_EQ(a.sgn(), 1);
+    EXPECT_EQ((-a).sgn(), -1);
+    EXPECT_EQ(a.bit_length(), 101u);
+    EXPECT_EQ((a - 1).bit_length(), 100u);
+    EXPECT_EQ(a.popcount(), 1u);
+    EXPECT_EQ((a - 1).popcount(), 100u);
+    EXPECT_EQ(a.count_trailing_zeros(), 100u);
+    EXPECT_EQ((-a).count_trailing_zeros(), 100u);
+    EXPECT_EQ((a + 8).count_trailing_zeros(), 3u);
+    EXPECT_TRUE(a.test_bit(100));
+    EXPECT_FALSE(a.test_bit(99));
+    EXPECT_FALSE(a.test_bit(1000));
+    EXPECT_EQ(big_integer(-1).bit_length(), 1u);
+}
+
+TEST(correctness, test_bit_twos_complement)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn)
+    {
+        big_integer a = rand_big(rand() % 4);
+        if (rand() % 2)
+            a = -a;
+        for (size_t bit = 0; bit < 200; bit += 1 + rand() % 7)
+        {
+            big_integer expected = (a >> static_cast<int>(bit)) & 1;
+            ASSERT_EQ(a.test_bit(bit), expected == 1);
+        }
+    }
+}
+
+TEST(correctness, set_clear_flip_bit)
+{
+    big_integer a;
+    a.set_bit(100);
+    EXPECT_EQ(a, big_integer(1) << 100);
+    a.set_bit(3);
+    EXPECT_EQ(a, (big_integer(1) << 100) + 8);
+    a.clear_bit(100);
+    EXPECT_EQ(a, 8);
+    a.clear_bit(1000);
+    EXPECT_EQ(a, 8);
+    a.flip_bit(3);
+    EXPECT_TRUE(a.is_zero());
+    EXPECT_EQ(to_string(a), "0");
+
+    big_integer b = -1;
+    b.set_bit(70);
+    EXPECT_EQ(b, -1);
+    b.clear_bit(0);
+    EXPECT_EQ(b, -2);
+    b.clear_bit(64);
+    EXPECT_EQ(b, -2 - (big_integer(1) << 64));
+    b.flip_bit(64);
+    EXPECT_EQ(b, -2);
+
+    big_integer c = big_integer(-1) << 64; // ...1 0{64}
+    c.set_bit(63);
+    EXPECT_EQ(c, -(big_integer(1) << 63));
+}
+
+TEST(correctness, bit_updates_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn)
+    {
+        big_integer a = rand_big(rand() % 4);
+        if (rand() % 2)
+            a = -a;
+        int bit = rand() % 150;
+        big_integer mask = big_integer(1) << bit;
+
+        big_integer b = a;
+        b.set_bit(bit);
+        ASSERT_EQ(b, a | mask);
+        b = a;
+        b.clear_bit(bit);
+        ASSERT_EQ(b, a & ~mask);
+        b = a;
+        b.flip_bit(bit);
+        ASSERT_EQ(b, a ^ mask);
+    }
+}
+
+TEST(correctness, truncate_and_mod_2exp)
+{
+    big_integer a("-123456789012345678901234567890");
+    for (size_t n = 0; n < 130; n += 7)
+    {
+        big_integer pow = big_integer(1) << static_cast<int>(n);
+
+        big_integer t = a;
+        t.truncate_to_bits(n);
+        EXPECT_EQ(t, a % pow);
+        t = -a;
+        t.truncate_to_bits(n);
+        EXPECT_EQ(t, -a % pow);
+
+        big_integer m = a;
+        m.mod_2exp(n);
+        EXPECT_EQ(m, a & (pow - 1));
+        EXPECT_GE(m, 0);
+        m = -a;
+        m.mod_2exp(n);
+        EXPECT_EQ(m, -a % pow);
+    }
+    big_integer b = big_integer(1) << 64;
+    b.mod_2exp(64);
+    EXPECT_TRUE(b.is_zero());
+    b = -(big_integer(1) << 64);
+    b.mod_2exp(64);
+    EXPECT_TRUE(b.is_zero());
+    b = -1;
+    b.mod_2exp(40);
+    EXPECT_EQ(b, (big_integer(1) << 40) - 1);
+}
+
+TEST(correctness, bitwise_not_top_bit)
+{
+    EXPECT_EQ(~big_integer(2147483648u), -2147483649ll);
+    EXPECT_EQ(~(big_integer(1) << 63), -(big_integer(1) << 63) - 1);
+    EXPECT_EQ(~big_integer(-2147483649ll), 2147483648u);
+    EXPECT_EQ(~big_integer(0), -1);
+    EXPECT_EQ(~big_integer(-1), 0);
+}
+
+TEST(correctness, divexact)
+{
+    big_integer a("123456789012345678901234567890123456789");
+    big_integer b("-98765432109876543210");
+    EXPECT_EQ(divexact(a * b, b), a);
+    EXPECT_EQ(divexact(a * b, a), b);
+    EXPECT_EQ(divexact(a * b, -a), -b);
+    EXPECT_EQ(divexact(big_integer(), b), 0);
+    EXPECT_EQ(divexact(a, big_integer(1)), a);
+    EXPECT_EQ(divexact(a << 200, big_integer(1) << 150), a << 50);
+    EXPECT_EQ(divexact(a << 200, a << 100), big_integer(1) << 100);
+    EXPECT_EQ(divexact(big_integer(-84), big_integer(12)), -7);
+}
+
+TEST(correctness, divexact_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        big_integer q = rand_big(rand() % 20), d = rand_big(rand() % 12) + 1;
+        if (rand() % 2)
+            d <<= rand() % 100;
+        if (rand() % 2)
+            q = -q;
+        if (rand() % 2)
+            d = -d;
+        ASSERT_EQ(divexact(q * d, d), q);
+    }
+}
+
+TEST(correctness, div_2exp_variants)
+{
+    EXPECT_EQ(tdiv_q_2exp(big_integer(-7), 1), -3);
+    EXPECT_EQ(fdiv_q_2exp(big_integer(-7), 1), -4);
+    EXPECT_EQ(cdiv_q_2exp(big_integer(-7), 1), -3);
+    EXPECT_EQ(tdiv_q_2exp(big_integer(7), 1), 3);
+    EXPECT_EQ(fdiv_q_2exp(big_integer(7), 1), 3);
+    EXPECT_EQ(cdiv_q_2exp(big_integer(7), 1), 4);
+    EXPECT_EQ(cdiv_q_2exp(big_integer(8), 3), 1);
+    EXPECT_EQ(fdiv_q_2exp(big_integer(-8), 3), -1);
+    EXPECT_EQ(cdiv_q_2exp(big_integer(5), 100), 1);
+    EXPECT_EQ(fdiv_q_2exp(big_integer(-5), 100), -1);
+    EXPECT_EQ(tdiv_q_2exp(big_integer(-5), 100), 0);
+
+    EXPECT_EQ(tdiv_r_2exp(big_integer(-7), 2), -3);
+    EXPECT_EQ(fdiv_r_2exp(big_integer(-7), 2), 1);
+    EXPECT_EQ(cdiv_r_2exp(big_integer(-7), 2), -3);
+    EXPECT_EQ(cdiv_r_2exp(big_integer(7), 2), -1);
+    EXPECT_EQ(cdiv_r_2exp(big_integer(8), 2), 0);
+}
+
+TEST(correctness, div_2exp_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        big_integer a = rand_big(rand() % 8);
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 4 == 0)
+            a <<= rand() % 100;
+        size_t n = rand() % 200;
+        big_integer pow = big_integer(1) << static_cast<int>(n);
+
+        big_integer tq = tdiv_q_2exp(a, n), fq = fdiv_q_2exp(a, n), cq = cdiv_q_2exp(a, n);
+        ASSERT_EQ(tq, a / pow);
+        ASSERT_EQ(tq * pow + tdiv_r_2exp(a, n), a);
+        ASSERT_EQ(fq * pow + fdiv_r_2exp(a, n), a);
+        ASSERT_EQ(cq * pow + cdiv_r_2exp(a, n), a);
+        ASSERT_GE(fdiv_r_2exp(a, n), 0);
+        ASSERT_LT(fdiv_r_2exp(a, n), pow);
+        ASSERT_LE(cdiv_r_2exp(a, n), 0);
+        ASSERT_GT(cdiv_r_2exp(a, n), -pow);
+        ASSERT_EQ(fq, a >> static_cast<int>(n));
+    }
+}
+
+TEST(correctness, division_rounding_modes)
+{
+    big_integer q, r;
+    fdiv_qr(q, r, big_integer(-7), big_integer(2));
+    EXPECT_EQ(q, -4);
+    EXPECT_EQ(r, 1);
+    fdiv_qr(q, r, big_integer(7), big_integer(-2));
+    EXPECT_EQ(q, -4);
+    EXPECT_EQ(r, -1);
+    cdiv_qr(q, r, big_integer(7), big_integer(2));
+    EXPECT_EQ(q, 4);
+    EXPECT_EQ(r, -1);
+    cdiv_qr(q, r, big_integer(-7), big_integer(-2));
+    EXPECT_EQ(q, 4);
+    EXPECT_EQ(r, 1);
+    ediv_qr(q, r, big_integer(-7), big_integer(-2));
+    EXPECT_EQ(q, 4);
+    EXPECT_EQ(r, 1);
+    ediv_qr(q, r, big_integer(-7), big_integer(2));
+    EXPECT_EQ(q, -4);
+    EXPECT_EQ(r, 1);
+    tdiv_qr(q, r, big_integer(-7), big_integer(2));
+    EXPECT_EQ(q, -3);
+    EXPECT_EQ(r, -1);
+
+    big_integer a("-1000000000000000000000000000000"), b("3000000000000000000000");
+    fdiv_qr(q, r, a, b);
+    EXPECT_EQ(q, big_integer("-333333334"));
+    EXPECT_EQ(r, big_integer("2000000000000000000000"));
+    cdiv_qr(q, r, b, a);
+    EXPECT_EQ(q, 0);
+    EXPECT_EQ(r, b);
+    fdiv_qr(q, r, b, a);
+    EXPECT_EQ(q, -1);
+    EXPECT_EQ(r, a + b);
+
+    // outputs may alias the inputs
+    big_integer x = a, y = b;
+    ediv_qr(x, y, x, y);
+    EXPECT_EQ(x * b + y, a);
+}
+
+TEST(correctness, division_rounding_modes_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        big_integer a = rand_big(rand() % 12), b = rand_big(rand() % 8) + 1;
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 2)
+            b = -b;
+
+        big_integer tq, tr, fq, fr, cq, cr, eq, er;
+        tdiv_qr(tq, tr, a, b);
+        fdiv_qr(fq, fr, a, b);
+        cdiv_qr(cq, cr, a, b);
+        ediv_qr(eq, er, a, b);
+
+        ASSERT_EQ(tq, a / b);
+        ASSERT_EQ(tr, a % b);
+        ASSERT_EQ(fq * b + fr, a);
+        ASSERT_EQ(cq * b + cr, a);
+        ASSERT_EQ(eq * b + er, a);
+        ASSERT_TRUE(fr.is_zero() || fr.sgn() == b.sgn());
+        ASSERT_TRUE(cr.is_zero() || cr.sgn() == -b.sgn());
+        ASSERT_GE(er, 0);
+        ASSERT_LT(cmp_abs(fr, b), 0);
+        ASSERT_LT(cmp_abs(cr, b), 0);
+        ASSERT_LT(cmp_abs(er, b), 0);
+    }
+}
+
+TEST(correctness, pow)
+{
+    EXPECT_EQ(pow(big_integer(), 0), 1);
+    EXPECT_EQ(pow(big_integer(), 5), 0);
+    EXPECT_EQ(pow(big_integer(7), 0), 1);
+    EXPECT_EQ(pow(big_integer(-2), 3), -8);
+    EXPECT_EQ(pow(big_integer(-2), 4), 16);
+    EXPECT_EQ(pow(big_integer(-1), 1000001), -1);
+    EXPECT_EQ(pow(big_integer(1), 1000000), 1);
+    EXPECT_EQ(pow(big_integer(2), 1000), big_integer(1) << 1000);
+    EXPECT_EQ(pow(big_integer(-8), 33), -(big_integer(1) << 99));
+    EXPECT_EQ(pow(big_integer(10), 30), big_integer("1000000000000000000000000000000"));
+    EXPECT_EQ(pow(big_integer(12), 20), pow(big_integer(3), 20) << 40);
+    EXPECT_EQ(pow(big_integer("4294967296"), 3), big_integer(1) << 96);
+}
+
+TEST(correctness, pow_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 10; ++itn)
+    {
+        big_integer a = rand_big(rand() % 4 + 1);
+        if (rand() % 2)
+            a <<= rand() % 70;
+        if (rand() % 2)
+            a = -a;
+        uint64_t e = rand() % 80;
+        big_integer expected = 1;
+        for (uint64_t k = 0; k != e; ++k)
+            expected *= a;
+        ASSERT_EQ(pow(a, e), expected);
+    }
+}
+
+namespace
+{
+    big_integer euclid_gcd(big_integer a, big_integer b)
+    {
+        a = abs(a);
+        b = abs(b);
+        while (b != 0)
+        {
+            big_integer r = a % b;
+            a = b;
+            b = r;
+        }
+        return a;
+    }
+}
+
+TEST(correctness, gcd_lcm)
+{
+    EXPECT_EQ(gcd(big_integer(), big_integer()), 0);
+    EXPECT_EQ(gcd(big_integer(), big_integer(-5)), 5);
+    EXPECT_EQ(gcd(big_integer(12), big_integer(-18)), 6);
+    EXPECT_EQ(gcd(big_integer(17), big_integer(5)), 1);
+    big_integer a("123456789012345678901234567890"), b("987654321098765432109876543210");
+    EXPECT_EQ(gcd(a, b), big_integer("9000000000900000000090"));
+    EXPECT_EQ(gcd(a << 300, a << 200), a << 200);
+    // consecutive Fibonacci numbers take the longest quotient sequence
+    big_integer f0 = 0, f1 = 1;
+    for (int i = 0; i != 2000; ++i)
+    {
+        big_integer f2 = f0 + f1;
+        f0 = f1;
+        f1 = f2;
+    }
+    EXPECT_EQ(gcd(f1, f0), 1);
+    EXPECT_EQ(gcd(f1 * 91, f0 * 91), 91);
+
+    EXPECT_EQ(lcm(big_integer(4), big_integer(-6)), 12);
+    EXPECT_EQ(lcm(big_integer(), big_integer(6)), 0);
+    EXPECT_EQ(lcm(a, b), a / gcd(a, b) * b);
+}
+
+TEST(correctness, gcd_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * 20; ++itn)
+    {
+        big_integer c = rand_big(rand() % 6);
+        big_integer a = rand_big(rand() % 30) * c, b = rand_big(rand() % 30) * c;
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 4 == 0)
+            b <<= rand() % 200;
+        ASSERT_EQ(gcd(a, b), euclid_gcd(a, b));
+    }
+}
+
+TEST(correctness, gcdext)
+{
+    big_integer g, s, t;
+    gcdext(g, s, t, big_integer(240), big_integer(46));
+    EXPECT_EQ(g, 2);
+    EXPECT_EQ(240 * s + 46 * t, 2);
+    gcdext(g, s, t, big_integer(), big_integer(-7));
+    EXPECT_EQ(g, 7);
+    EXPECT_EQ(s, 0);
+    EXPECT_EQ(t, -1);
+    gcdext(g, s, t, big_integer(-7), big_integer());
+    EXPECT_EQ(g, 7);
+    EXPECT_EQ(s, -1);
+    EXPECT_EQ(t, 0);
+    gcdext(g, s, t, big_integer(12), big_integer(4));
+    EXPECT_EQ(g, 4);
+    EXPECT_EQ(12 * s + 4 * t, 4);
+
+    for (size_t itn = 0; itn != number_of_iterations * 20; ++itn)
+    {
+        big_integer c = rand_big(rand() % 4);
+        big_integer a = rand_big(rand() % 25) * c, b = rand_big(rand() % 25) * c;
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 2)
+            b = -b;
+        if (rand() % 4 == 0)
+            a <<= rand() % 200;
+        gcdext(g, s, t, a, b);
+        ASSERT_EQ(g, euclid_gcd(a, b));
+        ASSERT_EQ(a * s + b * t, g);
+        // Euclid's cofactors are bounded by the other operand
+        ASSERT_LE(abs(s), abs(b));
+        ASSERT_LE(abs(t), abs(a));
+    }
+}
+
+TEST(correctness, gcd_large)
+{
+    // operands past the half-GCD threshold; a * s + b * t == g with g dividing both proves g is the gcd
+    for (size_t itn = 0; itn != 10; ++itn)
+    {
+        big_integer c = rand_big(rand() % 300);
+        big_integer a = rand_big(4400 + rand() % 1000) * c, b = rand_big(4400 + rand() % 1000) * c;
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 2)
+            b = -b;
+        if (rand() % 4 == 0)
+            b = a + c;
+        big_integer g, s, t;
+        gcdext(g, s, t, a, b);
+        ASSERT_EQ(a % g, 0);
+        ASSERT_EQ(b % g, 0);
+        ASSERT_EQ(g % c, 0);
+        ASSERT_EQ(a * s + b * t, g);
+        ASSERT_LE(abs(s), abs(b));
+        ASSERT_LE(abs(t), abs(a));
+        ASSERT_EQ(gcd(a, b), g);
+    }
+}
+
+TEST(correctness, sqrtrem)
+{
+    big_integer s, r;
+    sqrtrem(s, r, big_integer(0));
+    EXPECT_EQ(s, 0);
+    EXPECT_EQ(r, 0);
+    sqrtrem(s, r, big_integer(99));
+    EXPECT_EQ(s, 9);
+    EXPECT_EQ(r, 18);
+    EXPECT_EQ(isqrt(big_integer("18446744073709551615")), 4294967295u);
+    EXPECT_EQ(isqrt(big_integer("18446744073709551616")), big_integer(4294967296u));
+    big_integer p = big_integer(1) << 1000;
+    EXPECT_EQ(isqrt(p * p - 1), p - 1);
+    EXPECT_EQ(isqrt(p * p), p);
+
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        big_integer a = rand_big(rand() % 60);
+        if (rand() % 4 == 0)
+            a = a * a - rand() % 2;
+        sqrtrem(s, r, a);
+        ASSERT_EQ(s * s + r, a);
+        ASSERT_TRUE(r >= 0 && r <= 2 * s);
+        ASSERT_EQ(isqrt(a), s);
+    }
+}
+
+TEST(correctness, rootrem)
+{
+    big_integer root, rem;
+    rootrem(root, rem, big_integer(-30), 3);
+    EXPECT_EQ(root, -3);
+    EXPECT_EQ(rem, -3);
+    rootrem(root, rem, big_integer(1000), 1);
+    EXPECT_EQ(root, 1000);
+    EXPECT_EQ(rem, 0);
+    EXPECT_EQ(iroot(big_integer(1) << 300, 100), 8);
+    EXPECT_EQ(iroot(big_integer(1) << 300, 301), 1);
+    EXPECT_EQ(iroot(big_integer("18446744073709551615"), 3), 2642245);
+
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        unsigned k = rand() % 10 + 2;
+        big_integer a = rand_big(rand() % 60);
+        if (rand() % 4 == 0)
+            a = pow(a, k) - rand() % 2;
+        if (k % 2 && rand() % 2)
+            a = -a;
+        rootrem(root, rem, a, k);
+        ASSERT_EQ(pow(root, k) + rem, a);
+        // |root| is the largest value whose power does not pass |a|
+        ASSERT_LE(pow(abs(root), k), abs(a));
+        ASSERT_GT(pow(abs(root) + 1, k), abs(a));
+        ASSERT_EQ(iroot(a, k), root);
+    }
+}
+
+TEST(correctness, is_perfect_square)
+{
+    EXPECT_TRUE(is_perfect_square(big_integer(0)));
+    EXPECT_TRUE(is_perfect_square(big_integer(1)));
+    EXPECT_FALSE(is_perfect_square(big_integer(2)));
+    EXPECT_FALSE(is_perfect_square(big_integer(-4)));
+    for (int i = 0; i != 2000; ++i)
+        ASSERT_EQ(is_perfect_square(big_integer(i)), isqrt(big_integer(i)) * isqrt(big_integer(i)) == i);
+
+    for (size_t itn = 0; itn != number_of_iterations * 100; ++itn)
+    {
+        big_integer a = rand_big(rand() % 40) + 2;
+        ASSERT_TRUE(is_perfect_square(a * a));
+        ASSERT_FALSE(is_perfect_square(a * a + 1));
+        ASSERT_FALSE(is_perfect_square(a * a - 1));
+    }
+}
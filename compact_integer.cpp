@@ -0,0 +1,243 @@
+#include "compact_integer.h"
+
+#include <utility>
+
+bool compact_integer::fits_inline(int64_t x)
+{
+    return x >= INLINE_MIN && x <= INLINE_MAX;
+}
+
+uint64_t compact_integer::make_inline(int64_t x)
+{
+    return (static_cast<uint64_t>(x) << 1) | 1u;
+}
+
+bool compact_integer::is_inline() const
+{
+    return word & 1u;
+}
+
+int64_t compact_integer::inline_value() const
+{
+    return static_cast<int64_t>(word) >> 1;
+}
+
+big_integer* compact_integer::heap_value() const
+{
+    return reinterpret_cast<big_integer*>(static_cast<uintptr_t>(word));
+}
+
+void compact_integer::assign(big_integer const& x)
+{
+    // keep the representation canonical: everything that fits is inline
+    if (x.fits_int64() && fits_inline(x.to_int64()))
+    {
+        word = make_inline(x.to_int64());
+        return;
+    }
+    word = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(new big_integer(x)));
+}
+
+void compact_integer::assign_word(int64_t x)
+{
+    if (fits_inline(x))
+        word = make_inline(x);
+    else
+        assign(big_integer(x));
+}
+
+void compact_integer::assign_word(uint64_t x)
+{
+    if (x <= static_cast<uint64_t>(INLINE_MAX))
+        word = make_inline(static_cast<int64_t>(x));
+    else
+        assign(big_integer(x));
+}
+
+compact_integer::compact_integer() : word(make_inline(0)) {}
+
+compact_integer::compact_integer(big_integer const& a)
+{
+    assign(a);
+}
+
+compact_integer::compact_integer(std::string const& str)
+{
+    assign(big_integer(str));
+}
+
+compact_integer::compact_integer(compact_integer const& other)
+{
+    if (other.is_inline())
+        word = other.word;
+    else
+        word = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(new big_integer(*other.heap_value())));
+}
+
+compact_integer::compact_integer(compact_integer&& other) noexcept : word(other.word)
+{
+    other.word = make_inline(0);
+}
+
+compact_integer::~compact_integer()
+{
+    if (!is_inline())
+        delete heap_value();
+}
+
+compact_integer& compact_integer::operator=(compact_integer const& other)
+{
+    compact_integer tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+compact_integer& compact_integer::operator=(compact_integer&& other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+void compact_integer::swap(compact_integer& other) noexcept
+{
+    std::swap(word, other.word);
+}
+
+big_integer compact_integer::to_big_integer() const
+{
+    if (is_inline())
+        return big_integer(inline_value());
+    return *heap_value();
+}
+
+compact_integer operator+(compact_integer const& a, compact_integer const& b)
+{
+    if (a.is_inline() && b.is_inline())
+        return compact_integer(a.inline_value() + b.inline_value());
+    return compact_integer(a.to_big_integer() + b.to_big_integer());
+}
+
+compact_integer operator-(compact_integer const& a, compact_integer const& b)
+{
+    if (a.is_inline() && b.is_inline())
+        return compact_integer(a.inline_value() - b.inline_value());
+    return compact_integer(a.to_big_integer() - b.to_big_integer());
+}
+
+compact_integer operator*(compact_integer const& a, compact_integer const& b)
+{
+    int64_t result;
+    if (a.is_inline() && b.is_inline() && !__builtin_mul_overflow(a.inline_value(), b.inline_value(), &result))
+        return compact_integer(result);
+    return compact_integer(a.to_big_integer() * b.to_big_integer());
+}
+
+compact_integer operator/(compact_integer const& a, compact_integer const& b)
+{
+    // quotient of two 63-bit values always fits in int64_t
+    if (a.is_inline() && b.is_inline())
+        return compact_integer(a.inline_value() / b.inline_value());
+    return compact_integer(a.to_big_integer() / b.to_big_integer());
+}
+
+compact_integer operator%(compact_integer const& a, compact_integer const& b)
+{
+    if (a.is_inline() && b.is_inline())
+        return compact_integer(a.inline_value() % b.inline_value());
+    return compact_integer(a.to_big_integer() % b.to_big_integer());
+}
+
+compact_integer& compact_integer::operator+=(compact_integer const& rhs)
+{
+    return *this = *this + rhs;
+}
+
+compact_integer& compact_integer::operator-=(compact_integer const& rhs)
+{
+    return *this = *this - rhs;
+}
+
+compact_integer& compact_integer::operator*=(compact_integer const& rhs)
+{
+    return *this = *this * rhs;
+}
+
+compact_integer& compact_integer::operator/=(compact_integer const& rhs)
+{
+    return *this = *this / rhs;
+}
+
+compact_integer& compact_integer::operator%=(compact_integer const& rhs)
+{
+    return *this = *this % rhs;
+}
+
+compact_integer compact_integer::operator+() const
+{
+    return *this;
+}
+
+compact_integer compact_integer::operator-() const
+{
+    if (is_inline())
+        return compact_integer(-inline_value());
+    return compact_integer(-*heap_value());
+}
+
+int compare(compact_integer const& a, compact_integer const& b)
+{
+    if (a.is_inline() && b.is_inline())
+        return a.inline_value() < b.inline_value() ? -1 : (a.inline_value() > b.inline_value() ? 1 : 0);
+    if (!a.is_inline() && !b.is_inline())
+        return compare(*a.heap_value(), *b.heap_value());
+    // canonical representation: a heap value is outside the inline range, so its sign decides
+    if (a.is_inline())
+        return -b.heap_value()->sgn();
+    return a.heap_value()->sgn();
+}
+
+bool operator==(compact_integer const& a, compact_integer const& b)
+{
+    // canonical representation: an inline value never equals a heap one
+    if (a.is_inline() || b.is_inline())
+        return a.word == b.word;
+    return *a.heap_value() == *b.heap_value();
+}
+
+bool operator!=(compact_integer const& a, compact_integer const& b)
+{
+    return !(a == b);
+}
+
+bool operator<(compact_integer const& a, compact_integer const& b)
+{
+    return compare(a, b) < 0;
+}
+
+bool operator>(compact_integer const& a, compact_integer const& b)
+{
+    return compare(a, b) > 0;
+}
+
+bool operator<=(compact_integer const& a, compact_integer const& b)
+{
+    return compare(a, b) <= 0;
+}
+
+bool operator>=(compact_integer const& a, compact_integer const& b)
+{
+    return compare(a, b) >= 0;
+}
+
+std::string to_string(compact_integer const& a)
+{
+    if (a.is_inline())
+        return std::to_string(a.inline_value());
+    return to_string(*a.heap_value());
+}
+
+std::ostream& operator<<(std::ostream& s, compact_integer const& a)
+{
+    s << to_string(a);
+    return s;
+}
@@ -0,0 +1,102 @@
+#ifndef COMPACT_INTEGER_H
+#define COMPACT_INTEGER_H
+
+#include "big_integer.h"
+
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <type_traits>
+
+// Integer of the same value range as big_integer that occupies a single machine word.
+// Values in [-2^62, 2^62) are kept inline, anything else lives in a heap big_integer;
+// arithmetic on two inline values never allocates.
+class compact_integer
+{
+    // low bit set: the value is stored inline in the upper 63 bits;
+    // otherwise the word is a pointer to a big_integer owned by this object
+    uint64_t word;
+
+    static const int64_t INLINE_MIN = -(static_cast<int64_t>(1) << 62);
+    static const int64_t INLINE_MAX = (static_cast<int64_t>(1) << 62) - 1;
+
+    static bool fits_inline(int64_t x);
+    static uint64_t make_inline(int64_t x);
+
+    bool is_inline() const;
+    int64_t inline_value() const;
+    big_integer* heap_value() const;
+
+    void assign(big_integer const& x);
+    void assign_word(int64_t x);
+    void assign_word(uint64_t x);
+
+public:
+    compact_integer();
+    // any built-in integer type of at most 64 bits, signed or not
+    template <typename T, typename = enable_if_integral<T, void>>
+    compact_integer(T a);
+    compact_integer(big_integer const& a);
+    explicit compact_integer(std::string const& str);
+    compact_integer(compact_integer const& other);
+    compact_integer(compact_integer&& other) noexcept;
+    ~compact_integer();
+
+    compact_integer& operator=(compact_integer const& other);
+    compact_integer& operator=(compact_integer&& other) noexcept;
+
+    big_integer to_big_integer() const;
+
+    friend compact_integer operator+(compact_integer const& a, compact_integer const& b);
+    friend compact_integer operator-(compact_integer const& a, compact_integer const& b);
+    friend compact_integer operator*(compact_integer const& a, compact_integer const& b);
+    friend compact_integer operator/(compact_integer const& a, compact_integer const& b);
+    friend compact_integer operator%(compact_integer const& a, compact_integer const& b);
+
+    compact_integer& operator+=(compact_integer const& rhs);
+    compact_integer& operator-=(compact_integer const& rhs);
+    compact_integer& operator*=(compact_integer const& rhs);
+    compact_integer& operator/=(compact_integer const& rhs);
+    compact_integer& operator%=(compact_integer const& rhs);
+
+    compact_integer operator+() const;
+    compact_integer operator-() const;
+
+    friend int compare(compact_integer const& a, compact_integer const& b);
+    friend bool operator==(compact_integer const& a, compact_integer const& b);
+    friend bool operator!=(compact_integer const& a, compact_integer const& b);
+    friend bool operator<(compact_integer const& a, compact_integer const& b);
+    friend bool operator>(compact_integer const& a, compact_integer const& b);
+    friend bool operator<=(compact_integer const& a, compact_integer const& b);
+    friend bool operator>=(compact_integer const& a, compact_integer const& b);
+
+    friend std::string to_string(compact_integer const& a);
+
+    void swap(compact_integer& other) noexcept;
+};
+
+template <typename T, typename>
+compact_integer::compact_integer(T a)
+{
+    assign_word(static_cast<typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>(a));
+}
+
+compact_integer operator+(compact_integer const& a, compact_integer const& b);
+compact_integer operator-(compact_integer const& a, compact_integer const& b);
+compact_integer operator*(compact_integer const& a, compact_integer const& b);
+compact_integer operator/(compact_integer const& a, compact_integer const& b);
+compact_integer operator%(compact_integer const& a, compact_integer const& b);
+
+// -1, 0 or 1 as the sign of a - b
+int compare(compact_integer const& a, compact_integer const& b);
+bool operator==(compact_integer const& a, compact_integer const& b);
+bool operator!=(compact_integer const& a, compact_integer const& b);
+bool operator<(compact_integer const& a, compact_integer const& b);
+bool operator>(compact_integer const& a, compact_integer const& b);
+bool operator<=(compact_integer const& a, compact_integer const& b);
+bool operator>=(compact_integer const& a, compact_integer const& b);
+
+std::string to_string(compact_integer const& a);
+std::ostream& operator<<(std::ostream& s, compact_integer const& a);
+
+#endif // COMPACT_INTEGER_H
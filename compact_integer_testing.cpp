@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <utility>
+#include <gtest/gtest.h>
+
+#include "compact_integer.h"
+
+TEST(compact, size)
+{
+    EXPECT_LE(sizeof(compact_integer), 16u);
+}
+
+TEST(compact, two_plus_two)
+{
+    EXPECT_EQ(compact_integer(2) + compact_integer(2), compact_integer(4));
+    EXPECT_EQ(compact_integer(2) + 2, 4);
+    EXPECT_EQ(2 + compact_integer(2), 4);
+}
+
+TEST(compact, default_ctor)
+{
+    compact_integer a;
+    EXPECT_EQ(a, 0);
+    EXPECT_EQ(to_string(a), "0");
+}
+
+TEST(compact, arithmetic_small)
+{
+    compact_integer a = 1000000007;
+    compact_integer b = -37;
+
+    EXPECT_EQ(a + b, 999999970);
+    EXPECT_EQ(a - b, 1000000044);
+    EXPECT_EQ(a * b, -37000000259ll);
+    EXPECT_EQ(a / b, -27027027);
+    EXPECT_EQ(a % b, 8);
+    EXPECT_EQ(-a, -1000000007);
+}
+
+TEST(compact, overflow_to_heap)
+{
+    compact_integer a = (static_cast<int64_t>(1) << 62) - 1;
+
+    compact_integer b = a + 1;
+    EXPECT_EQ(to_string(b), "4611686018427387904");
+    EXPECT_EQ(b - 1, a);
+
+    compact_integer c = a * a;
+    EXPECT_EQ(c.to_big_integer(), big_integer("21267647932558653957237540927630737409"));
+    EXPECT_EQ(c / a, a);
+    EXPECT_EQ(c % a, 0);
+}
+
+TEST(compact, int64_limits)
+{
+    compact_integer a = std::numeric_limits<int64_t>::min();
+    compact_integer b = std::numeric_limits<int64_t>::max();
+
+    EXPECT_EQ(to_string(a), "-9223372036854775808");
+    EXPECT_EQ(to_string(b), "9223372036854775807");
+    EXPECT_EQ(a + b, -1);
+    EXPECT_EQ(-a, b + 1);
+}
+
+TEST(compact, uint64_values)
+{
+    compact_integer a = std::numeric_limits<uint64_t>::max();
+    compact_integer b = 1ull << 63;
+    compact_integer c = (1ull << 62) - 1;
+
+    EXPECT_EQ(to_string(a), "18446744073709551615");
+    EXPECT_EQ(to_string(b), "9223372036854775808");
+    EXPECT_NE(a, -1);
+    EXPECT_GT(b, 0);
+    EXPECT_EQ(a - b, b - 1);
+    EXPECT_EQ(b, -compact_integer(std::numeric_limits<int64_t>::min()));
+    EXPECT_EQ(c + 1, compact_integer(1ull << 62));
+    EXPECT_EQ(a.to_big_integer(), big_integer("18446744073709551615"));
+    EXPECT_EQ(compact_integer(static_cast<unsigned char>(200)), 200);
+}
+
+TEST(compact, inline_min_division)
+{
+    compact_integer a = -(static_cast<int64_t>(1) << 62);
+
+    EXPECT_EQ(to_string(a / -1), "4611686018427387904");
+    EXPECT_EQ(to_string(-a), "4611686018427387904");
+}
+
+TEST(compact, back_to_inline)
+{
+    compact_integer a("100000000000000000000000000000");
+    compact_integer b("99999999999999999999999999999");
+
+    EXPECT_EQ(a - b, 1);
+    EXPECT_EQ(a / b, 1);
+}
+
+TEST(compact, comparisons)
+{
+    compact_integer a = 100;
+    compact_integer b("100000000000000000000000000000");
+    compact_integer c("-100000000000000000000000000000");
+
+    EXPECT_TRUE(a < b);
+    EXPECT_TRUE(c < a);
+    EXPECT_TRUE(c < b);
+    EXPECT_TRUE(b >= a);
+    EXPECT_TRUE(a <= a);
+    EXPECT_TRUE(b != a);
+    EXPECT_TRUE(b == -c);
+}
+
+TEST(compact, copy_and_move)
+{
+    compact_integer a("123456789012345678901234567890");
+    compact_integer b = a;
+    b += 1;
+    EXPECT_EQ(to_string(a), "123456789012345678901234567890");
+    EXPECT_EQ(to_string(b), "123456789012345678901234567891");
+
+    compact_integer c = std::move(b);
+    EXPECT_EQ(to_string(c), "123456789012345678901234567891");
+
+    a = c;
+    a = a;
+    EXPECT_EQ(a, c);
+}
+
+TEST(compact, matches_big_integer_randomized)
+{
+    for (size_t itn = 0; itn != 10000; ++itn)
+    {
+        int64_t x = (static_cast<int64_t>(rand()) << 33) ^ (static_cast<int64_t>(rand()) << 2) ^ rand();
+        int64_t y = (static_cast<int64_t>(rand()) << (rand() % 34)) - RAND_MAX / 2;
+        if (y == 0)
+            y = 1;
+        if (rand() % 2)
+            x = -x;
+
+        compact_integer a(x), b(y);
+        big_integer ba = a.to_big_integer(), bb = b.to_big_integer();
+
+        ASSERT_EQ((a + b).to_big_integer(), ba + bb);
+        ASSERT_EQ((a - b).to_big_integer(), ba - bb);
+        ASSERT_EQ((a * b).to_big_integer(), ba * bb);
+        ASSERT_EQ((a / b).to_big_integer(), ba / bb);
+        ASSERT_EQ((a % b).to_big_integer(), ba % bb);
+        ASSERT_EQ(a < b, ba < bb);
+    }
+}
+
+TEST(compact, compare_inline_and_heap)
+{
+    compact_integer small(-5), big_pos(big_integer("100000000000000000000")), big_neg(big_integer("-100000000000000000000"));
+
+    EXPECT_EQ(compare(small, small), 0);
+    EXPECT_EQ(compare(small, big_pos), -1);
+    EXPECT_EQ(compare(big_pos, small), 1);
+    EXPECT_EQ(compare(small, big_neg), 1);
+    EXPECT_EQ(compare(big_neg, small), -1);
+    EXPECT_EQ(compare(big_neg, big_pos), -1);
+    EXPECT_EQ(compare(big_pos, big_pos), 0);
+    EXPECT_TRUE(big_neg < small);
+    EXPECT_TRUE(big_pos >= small);
+}
@@ -0,0 +1,430 @@
+#include "modular.h"
+#include "mpn.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    // x mod m in [0, m) for m > 0
+    big_integer reduce(big_integer const& x, big_integer const& m)
+    {
+        big_integer r = x % m;
+        if (r.sgn() < 0)
+            r += m;
+        return r;
+    }
+
+    // sliding window width for an exponent of the given length: the 2^(w - 1) precomputed odd powers
+    // pay for themselves once they save more multiplications than they cost
+    unsigned window_bits(size_t exp_bits)
+    {
+        static const size_t limits[] = {8, 24, 80, 240, 672};
+        unsigned w = 1;
+        while (w <= 5 && exp_bits > limits[w - 1])
+            ++w;
+        return w;
+    }
+}
+
+montgomery_context::montgomery_context(big_integer const& modulus)
+{
+    big_integer abs_modulus = abs(modulus);
+    m = abs_modulus.number;
+    size_t n = m.size();
+    minv = -mpn::binvert_limb(m[0]);
+
+    size_t n_bits = n * big_integer::LOG_BASE;
+    big_integer one_value = (big_integer(1) << n_bits) % abs_modulus;
+    big_integer r_squared_value = (big_integer(1) << (2 * n_bits)) % abs_modulus;
+    one.assign(n, 0);
+    r_squared.assign(n, 0);
+    if (!one_value.is_zero())
+        std::copy(one_value.number.cbegin(), one_value.number.cend(), one.mutable_data());
+    if (!r_squared_value.is_zero())
+        std::copy(r_squared_value.number.cbegin(), r_squared_value.number.cend(), r_squared.mutable_data());
+}
+
+size_t montgomery_context::size() const
+{
+    return m.size();
+}
+
+big_integer montgomery_context::modulus() const
+{
+    return big_integer(m);
+}
+
+void montgomery_context::to_montgomery(uint32_t* r, big_integer const& x) const
+{
+    size_t n = size();
+    big_integer value = reduce(x, modulus());
+    limb_vector tmp;
+    tmp.assign(3 * n, 0);
+    uint32_t* a = tmp.mutable_data();
+    if (!value.is_zero())
+        std::copy(value.number.cbegin(), value.number.cend(), a);
+    // x * R^2 / R = x * R
+    mul(r, a, r_squared.cbegin(), a + n);
+}
+
+big_integer montgomery_context::from_montgomery(const uint32_t* a) const
+{
+    size_t n = size();
+    limb_vector t;
+    t.assign(2 * n, 0);
+    uint32_t* td = t.mutable_data();
+    std::copy(a, a + n, td);
+    // x * R / R = x
+    mpn::redc_1(td, td, m.cbegin(), n, minv);
+    t.resize(n);
+    return big_integer(t);
+}
+
+void montgomery_context::mul(uint32_t* r, const uint32_t* a, const uint32_t* b, uint32_t* scratch) const
+{
+    size_t n = size();
+    mpn::mul(scratch, a, n, b, n);
+    mpn::redc_1(r, scratch, m.cbegin(), n, minv);
+}
+
+void montgomery_context::sqr(uint32_t* r, const uint32_t* a, uint32_t* scratch) const
+{
+    size_t n = size();
+    mpn::sqr(scratch, a, n);
+    mpn::redc_1(r, scratch, m.cbegin(), n, minv);
+}
+
+void montgomery_context::add(uint32_t* r, const uint32_t* a, const uint32_t* b) const
+{
+    size_t n = size();
+    // a + b < 2m: m is subtracted unconditionally and added back when the sum was below m
+    uint32_t carry = mpn::add_n(r, a, b, n);
+    uint32_t borrow = mpn::sub_n(r, r, m.cbegin(), n);
+    mpn::cnd_add_n(borrow & (carry ^ 1u), r, r, m.cbegin(), n);
+}
+
+void montgomery_context::sub(uint32_t* r, const uint32_t* a, const uint32_t* b) const
+{
+    size_t n = size();
+    uint32_t borrow = mpn::sub_n(r, a, b, n);
+    mpn::cnd_add_n(borrow, r, r, m.cbegin(), n);
+}
+
+void montgomery_context::to_montgomery(uint32_t* r, const uint32_t* a, uint32_t* scratch) const
+{
+    // a * R^2 / R = a * R
+    mul(r, a, r_squared.cbegin(), scratch);
+}
+
+void montgomery_context::from_montgomery(uint32_t* r, const uint32_t* a, uint32_t* scratch) const
+{
+    size_t n = size();
+    std::copy(a, a + n, scratch);
+    std::fill(scratch + n, scratch + 2 * n, 0);
+    mpn::redc_1(r, scratch, m.cbegin(), n, minv);
+}
+
+void montgomery_context::powmod_sec(uint32_t* r, const uint32_t* base, const uint32_t* exp, size_t exp_bits) const
+{
+    static const unsigned WINDOW = 4;
+    static const size_t ENTRIES = 1u << WINDOW;
+    size_t n = size();
+    limb_vector buffers;
+    buffers.resize_uninitialized((ENTRIES + 3) * n);
+    uint32_t* table = buffers.mutable_data();
+    uint32_t* factor = table + ENTRIES * n;
+    uint32_t* scratch = factor + n;
+
+    // table[k] = base^k, including base^0 so that every window costs the same
+    std::copy(one.cbegin(), one.cend(), table);
+    std::copy(base, base + n, table + n);
+    for (size_t k = 2; k < ENTRIES; ++k)
+        mul(table + k * n, table + (k - 1) * n, base, scratch);
+
+    std::copy(one.cbegin(), one.cend(), r);
+    size_t windows = (exp_bits + WINDOW - 1) / WINDOW;
+    for (size_t w = windows; w-- > 0;)
+    {
+        for (unsigned k = 0; k < WINDOW; ++k)
+            sqr(r, r, scratch);
+        // bit positions are public, only the bit values are secret
+        size_t value = 0;
+        for (size_t bit = (w + 1) * WINDOW; bit-- > w * WINDOW;)
+        {
+            uint32_t b = bit < exp_bits ? (exp[bit / big_integer::LOG_BASE] >> (bit % big_integer::LOG_BASE)) & 1u : 0;
+            value = 2 * value + b;
+        }
+        mpn::tabselect(factor, table, n, ENTRIES, value);
+        mul(r, r, factor, scratch);
+    }
+}
+
+big_integer montgomery_context::powmod_sec(big_integer const& base, big_integer const& exp, size_t exp_bits) const
+{
+    if (exp.sign || exp.bit_length() > exp_bits)
+        throw std::runtime_error("powmod_sec exponent is negative or wider than exp_bits");
+
+    size_t n = size();
+    size_t exp_limbs = (exp_bits + big_integer::LOG_BASE - 1) / big_integer::LOG_BASE;
+    limb_vector buffers;
+    buffers.assign(2 * n + exp_limbs, 0);
+    uint32_t* b = buffers.mutable_data();
+    uint32_t* r = b + n;
+    uint32_t* e = r + n;
+    size_t used = (exp.bit_length() + big_integer::LOG_BASE - 1) / big_integer::LOG_BASE;
+    std::copy(exp.number.cbegin(), exp.number.cbegin() + used, e);
+
+    to_montgomery(b, base);
+    powmod_sec(r, b, e, exp_bits);
+    return from_montgomery(r);
+}
+
+big_integer montgomery_context::powmod(big_integer const& base, big_integer const& exp) const
+{
+    size_t n = size();
+    size_t exp_bits = exp.bit_length();
+    if (exp_bits == 0)
+        return from_montgomery(one.cbegin());
+
+    // odd powers base^1, base^3, ..., base^(2^w - 1) in Montgomery form, one table of n-limb entries
+    unsigned window = window_bits(exp_bits);
+    size_t entries = static_cast<size_t>(1) << (window - 1);
+    limb_vector buffers;
+    buffers.resize_uninitialized((entries + 4) * n);
+    uint32_t* table = buffers.mutable_data();
+    uint32_t* acc = table + entries * n;
+    uint32_t* square = acc + n;
+    uint32_t* scratch = square + n;
+
+    to_montgomery(table, base);
+    if (entries > 1)
+    {
+        sqr(square, table, scratch);
+        for (size_t k = 1; k < entries; ++k)
+            mul(table + k * n, table + (k - 1) * n, square, scratch);
+    }
+
+    bool started = false;
+    for (size_t i = exp_bits; i-- > 0;)
+    {
+        if (!exp.test_bit(i))
+        {
+            sqr(acc, acc, scratch);
+            continue;
+        }
+
+        // the longest window of at most w bits that starts at bit i and ends with a one
+        size_t low = i + 1 > window ? i + 1 - window : 0;
+        while (!exp.test_bit(low))
+            ++low;
+        size_t value = 0;
+        for (size_t k = i + 1; k-- > low;)
+            value = 2 * value + exp.test_bit(k);
+        const uint32_t* factor = table + (value >> 1) * n;
+
+        if (!started)
+        {
+            std::copy(factor, factor + n, acc);
+            started = true;
+        }
+        else
+        {
+            for (size_t k = low; k <= i; ++k)
+                sqr(acc, acc, scratch);
+            mul(acc, acc, factor, scratch);
+        }
+        i = low;
+    }
+    return from_montgomery(acc);
+}
+
+barrett_reducer::barrett_reducer(big_integer const& modulus)
+{
+    big_integer abs_modulus = abs(modulus);
+    m = abs_modulus.number;
+    mu = ((big_integer(1) << (2 * m.size() * big_integer::LOG_BASE)) / abs_modulus).number;
+}
+
+size_t barrett_reducer::size() const
+{
+    return m.size();
+}
+
+big_integer barrett_reducer::modulus() const
+{
+    return big_integer(m);
+}
+
+big_integer barrett_reducer::reduce(big_integer const& x) const
+{
+    size_t k = size();
+    size_t xn = x.size();
+    if (xn < k || x.is_zero())
+        return x;
+    if (xn > 2 * k)
+        return x % modulus();
+
+    // q = floor(floor(x / B^(k-1)) * mu / B^(k+1)) is at most two below floor(x / m). Only the high limbs
+    // of the first product matter: partial products below limb k - 1 are skipped, which can lower q by
+    // one more but keeps q <= floor(x / m)
+    const uint32_t* xd = x.number.cbegin();
+    const uint32_t* q1 = xd + (k - 1);
+    size_t q1n = xn - (k - 1);
+    const uint32_t* mud = mu.cbegin();
+    size_t mun = mu.size();
+    limb_vector buffer;
+    buffer.assign((k + 1) + q1n + mun, 0);
+    uint32_t* r = buffer.mutable_data();
+    uint32_t* q2 = r + (k + 1);
+    for (size_t j = 0; j < q1n; ++j)
+    {
+        size_t i = j + 1 < k ? k - 1 - j : 0;
+        if (i < mun)
+            q2[j + mun] = mpn::addmul_1(q2 + j + i, mud + i, mun - i, q1[j]);
+    }
+    const uint32_t* q3 = q2 + (k + 1);
+    size_t q3n = mpn::normalized_size(q3, q1n + mun - (k + 1));
+
+    // r = x - q * m is below a few m, so only the low k + 1 limbs of q * m are needed; the rows are
+    // truncated there and only row 0 has its high limb inside that range
+    std::copy(xd, xd + std::min(xn, k + 1), r);
+    const uint32_t* md = m.cbegin();
+    for (size_t j = 0; j < q3n && j < k + 1; ++j)
+    {
+        uint32_t high = mpn::submul_1(r + j, md, std::min(k, k + 1 - j), q3[j]);
+        if (j == 0)
+            r[k] -= high;
+    }
+    while (mpn::cmp(r, mpn::normalized_size(r, k + 1), md, k) >= 0)
+        mpn::sub(r, r, k + 1, md, k);
+    buffer.resize(k + 1);
+    return big_integer(buffer, x.sign);
+}
+
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod)
+{
+    big_integer m = abs(mod);
+    if (m.test_bit(0))
+        return montgomery_context(m).powmod(base, exp);
+
+    // even moduli have no Montgomery form: plain square-and-multiply with a division per step
+    big_integer b = reduce(base, m);
+    big_integer result = reduce(1, m);
+    for (size_t i = exp.bit_length(); i-- > 0;)
+    {
+        result = result * result % m;
+        if (exp.test_bit(i))
+            result = result * b % m;
+    }
+    return result;
+}
+
+big_integer invert(big_integer const& a, big_integer const& mod)
+{
+    big_integer g, s, t;
+    gcdext(g, s, t, a, mod);
+    if (g != 1)
+        return 0;
+    return reduce(s, abs(mod));
+}
+
+mod_int::mod_int(big_integer const& value, std::shared_ptr<barrett_reducer const> modulus)
+    : modulus(std::move(modulus)), representative(value)
+{
+    reduce_if_large();
+}
+
+big_integer mod_int::reduced_below(size_t bits) const
+{
+    if (representative.bit_length() > bits)
+        return modulus->reduce(representative);
+    return representative;
+}
+
+void mod_int::reduce_if_large()
+{
+    representative = reduced_below(2 * modulus->size() * mpn::LIMB_BITS - 1);
+}
+
+std::shared_ptr<barrett_reducer const> const& mod_int::context() const
+{
+    return modulus;
+}
+
+big_integer mod_int::value() const
+{
+    big_integer r = modulus->reduce(representative);
+    if (r.sgn() < 0)
+        r += modulus->modulus();
+    return r;
+}
+
+mod_int& mod_int::operator+=(mod_int const& rhs)
+{
+    representative += rhs.representative;
+    reduce_if_large();
+    return *this;
+}
+
+mod_int& mod_int::operator-=(mod_int const& rhs)
+{
+    representative -= rhs.representative;
+    reduce_if_large();
+    return *this;
+}
+
+mod_int& mod_int::operator*=(mod_int const& rhs)
+{
+    // factors below B^k keep the product below B^2k, where reduce never falls back to division
+    size_t bits = modulus->size() * mpn::LIMB_BITS;
+    representative = reduced_below(bits) * rhs.reduced_below(bits);
+    reduce_if_large();
+    return *this;
+}
+
+mod_int& mod_int::operator/=(mod_int const& rhs)
+{
+    return *this *= rhs.inverse();
+}
+
+mod_int mod_int::operator-() const
+{
+    return mod_int(-representative, modulus);
+}
+
+mod_int mod_int::inverse() const
+{
+    return mod_int(invert(representative, modulus->modulus()), modulus);
+}
+
+bool operator==(mod_int const& a, mod_int const& b)
+{
+    return a.modulus->reduce(a.representative - b.representative).is_zero();
+}
+
+bool operator!=(mod_int const& a, mod_int const& b)
+{
+    return !(a == b);
+}
+
+mod_int operator+(mod_int a, mod_int const& b)
+{
+    return a += b;
+}
+
+mod_int operator-(mod_int a, mod_int const& b)
+{
+    return a -= b;
+}
+
+mod_int operator*(mod_int a, mod_int const& b)
+{
+    return a *= b;
+}
+
+mod_int operator/(mod_int a, mod_int const& b)
+{
+    return a /= b;
+}
@@ -0,0 +1,121 @@
+#ifndef MODULAR_H
+#define MODULAR_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Montgomery arithmetic modulo a fixed odd modulus m of n limbs. Residues are kept as x * R mod m with
+// R = B^n in spans of exactly n limbs, so a modular product costs two fixed-size n-limb passes instead
+// of a division. A context is immutable once built and may be shared by any number of computations.
+class montgomery_context
+{
+    limb_vector m;
+    limb_vector r_squared; // R^2 mod m
+    limb_vector one;       // R mod m, 1 in Montgomery form
+    uint32_t minv;         // -m^-1 mod 2^32
+
+public:
+    // |modulus| must be odd
+    explicit montgomery_context(big_integer const& modulus);
+
+    // limbs in every Montgomery-form span
+    size_t size() const;
+    big_integer modulus() const;
+
+    // r[0..n) = x mod m in Montgomery form
+    void to_montgomery(uint32_t* r, big_integer const& x) const;
+    // the value in [0, m) represented by a[0..n)
+    big_integer from_montgomery(const uint32_t* a) const;
+    // base^exp mod m in [0, m), exp >= 0; sliding windows, so the time depends on the exponent
+    big_integer powmod(big_integer const& base, big_integer const& exp) const;
+
+    // Everything below runs in time that depends on n (and the exponent width) only. Operands are n-limb
+    // spans below m; conversions from and to big_integer are not constant-time, so secrets stay in spans.
+
+    // r[0..n) = a * b / R mod m; scratch holds 2n limbs, r may be equal to a or b
+    void mul(uint32_t* r, const uint32_t* a, const uint32_t* b, uint32_t* scratch) const;
+    // r[0..n) = a^2 / R mod m; scratch holds 2n limbs, r may be equal to a
+    void sqr(uint32_t* r, const uint32_t* a, uint32_t* scratch) const;
+    // r[0..n) = a + b mod m and a - b mod m, in either form; r may be equal to a or b
+    void add(uint32_t* r, const uint32_t* a, const uint32_t* b) const;
+    void sub(uint32_t* r, const uint32_t* a, const uint32_t* b) const;
+    // r[0..n) = a in Montgomery form, and back; scratch holds 2n limbs, r may be equal to a
+    void to_montgomery(uint32_t* r, const uint32_t* a, uint32_t* scratch) const;
+    void from_montgomery(uint32_t* r, const uint32_t* a, uint32_t* scratch) const;
+    // r[0..n) = base^exp in Montgomery form, exp given as exp_bits bits in ceil(exp_bits / 32) limbs;
+    // fixed 4-bit windows, every table entry is read for each lookup; r must not overlap the inputs
+    void powmod_sec(uint32_t* r, const uint32_t* base, const uint32_t* exp, size_t exp_bits) const;
+
+    // base^exp mod m through the span powmod_sec, for 0 <= exp < 2^exp_bits (std::runtime_error otherwise);
+    // only the exponentiation itself is constant-time
+    big_integer powmod_sec(big_integer const& base, big_integer const& exp, size_t exp_bits) const;
+};
+
+// Barrett reduction by a fixed modulus m of k limbs: with mu = floor(B^2k / m) precomputed, the
+// remainder of any x below B^2k takes two multiplications and at most two subtractions.
+class barrett_reducer
+{
+    limb_vector m;
+    limb_vector mu; // floor(B^2k / m)
+
+public:
+    // modulus != 0; only |modulus| matters
+    explicit barrett_reducer(big_integer const& modulus);
+
+    // limbs in the modulus, k
+    size_t size() const;
+    big_integer modulus() const;
+
+    // x % m with the sign of x, as operator% gives; inputs of more than 2k limbs fall back to division
+    big_integer reduce(big_integer const& x) const;
+};
+
+// base^exp mod |mod| in [0, |mod|), exp >= 0, mod != 0; odd moduli go through a montgomery_context,
+// build one directly to reuse it across calls with the same modulus
+big_integer powmod(big_integer const& base, big_integer const& exp, big_integer const& mod);
+// a^-1 mod |mod| in [0, |mod|), mod != 0; 0 when gcd(a, mod) != 1, so no inverse exists
+big_integer invert(big_integer const& a, big_integer const& mod);
+
+// A residue modulo the modulus of a shared barrett_reducer. The stored representative is only congruent
+// to the residue and is reduced once it passes B^2k / 2 rather than after every step: sums and unreduced
+// products accumulate until then, and each reduction stays in the reducer's single-pass range. Factors of
+// a product are first brought below B^k. Operands of a binary operator must share the modulus.
+class mod_int
+{
+    std::shared_ptr<barrett_reducer const> modulus;
+    big_integer representative; // |representative| < B^2k / 2
+
+    // the representative, reduced when it has more than the given number of bits
+    big_integer reduced_below(size_t bits) const;
+    void reduce_if_large();
+
+public:
+    mod_int(big_integer const& value, std::shared_ptr<barrett_reducer const> modulus);
+
+    std::shared_ptr<barrett_reducer const> const& context() const;
+    // the residue in [0, m)
+    big_integer value() const;
+
+    mod_int& operator+=(mod_int const& rhs);
+    mod_int& operator-=(mod_int const& rhs);
+    mod_int& operator*=(mod_int const& rhs);
+    // rhs must be invertible modulo m
+    mod_int& operator/=(mod_int const& rhs);
+
+    mod_int operator-() const;
+    // the inverse modulo m, which must exist
+    mod_int inverse() const;
+
+    friend bool operator==(mod_int const& a, mod_int const& b);
+    friend bool operator!=(mod_int const& a, mod_int const& b);
+};
+
+mod_int operator+(mod_int a, mod_int const& b);
+mod_int operator-(mod_int a, mod_int const& b);
+mod_int operator*(mod_int a, mod_int const& b);
+mod_int operator/(mod_int a, mod_int const& b);
+
+#endif // MODULAR_H
@@ -0,0 +1,853 @@
+#include "mpn.h"
+#include "optimized_vector.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // scratch buffers of typical divisions stay on the stack
+    typedef basic_optimized_vector<32> scratch_vector;
+}
+
+uint32_t mpn::add_n(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n)
+{
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t sum = static_cast<uint64_t>(a[i]) + b[i] + carry;
+        r[i] = static_cast<uint32_t>(sum);
+        carry = sum >> LIMB_BITS;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+uint32_t mpn::add_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b)
+{
+    size_t i = 0;
+    uint32_t carry = b;
+    for (; i < n && carry; ++i)
+    {
+        uint32_t sum = a[i] + carry;
+        carry = (sum < carry);
+        r[i] = sum;
+    }
+    if (r != a)
+        std::copy(a + i, a + n, r + i);
+    return carry;
+}
+
+uint32_t mpn::add(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    uint32_t carry = add_n(r, a, b, bn);
+    return add_1(r + bn, a + bn, an - bn, carry);
+}
+
+uint32_t mpn::sub_n(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n)
+{
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t diff = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+        r[i] = static_cast<uint32_t>(diff);
+        borrow = diff >> (2 * LIMB_BITS - 1);
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+uint32_t mpn::sub_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b)
+{
+    size_t i = 0;
+    uint32_t borrow = b;
+    for (; i < n && borrow; ++i)
+    {
+        uint32_t x = a[i];
+        r[i] = x - borrow;
+        borrow = (x < borrow);
+    }
+    if (r != a)
+        std::copy(a + i, a + n, r + i);
+    return borrow;
+}
+
+uint32_t mpn::sub(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    uint32_t borrow = sub_n(r, a, b, bn);
+    return sub_1(r + bn, a + bn, an - bn, borrow);
+}
+
+uint32_t mpn::mul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b)
+{
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t cur = static_cast<uint64_t>(a[i]) * b + carry;
+        r[i] = static_cast<uint32_t>(cur);
+        carry = cur >> LIMB_BITS;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+uint32_t mpn::addmul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b)
+{
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        // (2^32 - 1)^2 + 2 * (2^32 - 1) == 2^64 - 1, so this never overflows
+        uint64_t cur = static_cast<uint64_t>(a[i]) * b + r[i] + carry;
+        r[i] = static_cast<uint32_t>(cur);
+        carry = cur >> LIMB_BITS;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+uint32_t mpn::submul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b)
+{
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t prod = static_cast<uint64_t>(a[i]) * b + borrow;
+        auto low = static_cast<uint32_t>(prod);
+        uint32_t x = r[i];
+        r[i] = x - low;
+        borrow = (prod >> LIMB_BITS) + (x < low);
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+namespace
+{
+    // operand sizes from which Karatsuba beats the schoolbook loops
+    const size_t KARATSUBA_MUL_THRESHOLD = 48;
+    const size_t KARATSUBA_SQR_THRESHOLD = 64;
+
+    void mul_basecase(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+    {
+        r[an] = mpn::mul_1(r, a, an, b[0]);
+        for (size_t i = 1; i < bn; ++i)
+            r[an + i] = mpn::addmul_1(r + i, a, an, b[i]);
+    }
+
+    void sqr_basecase(uint32_t* r, const uint32_t* a, size_t n)
+    {
+        // sum of a[i] * a[j] for i < j, doubled, plus the squares on the diagonal
+        std::fill(r, r + 2 * n, 0);
+        for (size_t i = 0; i + 1 < n; ++i)
+            r[i + n] = mpn::addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+        mpn::lshift(r, r, 2 * n, 1);
+
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t square = static_cast<uint64_t>(a[i]) * a[i];
+            uint64_t low = static_cast<uint64_t>(r[2 * i]) + static_cast<uint32_t>(square) + carry;
+            r[2 * i] = static_cast<uint32_t>(low);
+            uint64_t high = static_cast<uint64_t>(r[2 * i + 1]) + (square >> mpn::LIMB_BITS) + (low >> mpn::LIMB_BITS);
+            r[2 * i + 1] = static_cast<uint32_t>(high);
+            carry = high >> mpn::LIMB_BITS;
+        }
+    }
+
+    // The Karatsuba code below branches on sizes only, like the basecases, so mul and sqr stay
+    // constant-time: signs are handled with masks and carries are propagated through every limb.
+
+    // r[0..n) += carry, returns the carry out
+    uint32_t add_carry(uint32_t* r, size_t n, uint32_t carry)
+    {
+        uint64_t c = carry;
+        for (size_t i = 0; i < n; ++i)
+        {
+            c += r[i];
+            r[i] = static_cast<uint32_t>(c);
+            c >>= mpn::LIMB_BITS;
+        }
+        return static_cast<uint32_t>(c);
+    }
+
+    // r[0..h) = |a[0..h) - b[0..l)|, l <= h; returns 1 when a < b
+    uint32_t abs_diff(uint32_t* r, const uint32_t* a, size_t h, const uint32_t* b, size_t l)
+    {
+        uint32_t borrow = mpn::sub_n(r, a, b, l);
+        uint64_t c = borrow;
+        for (size_t i = l; i < h; ++i)
+        {
+            uint64_t diff = static_cast<uint64_t>(a[i]) - c;
+            r[i] = static_cast<uint32_t>(diff);
+            c = diff >> (2 * mpn::LIMB_BITS - 1);
+        }
+        // a negative difference is negated in place: -x == ~x + 1
+        auto negative = static_cast<uint32_t>(c);
+        uint32_t mask = 0u - negative;
+        uint64_t carry = negative;
+        for (size_t i = 0; i < h; ++i)
+        {
+            carry += r[i] ^ mask;
+            r[i] = static_cast<uint32_t>(carry);
+            carry >>= mpn::LIMB_BITS;
+        }
+        return negative;
+    }
+
+    // r[h..2n) += z0 + z2 - t (or + t when add_t is set), where z0 = r[0..2h) and z2 = r[2h..2n)
+    void karatsuba_middle(uint32_t* r, size_t n, size_t h, const uint32_t* t, uint32_t add_t, uint32_t* tmp)
+    {
+        size_t l = n - h;
+        uint32_t carry = mpn::add_n(tmp, r, r + 2 * h, 2 * l);
+        for (size_t i = 2 * l; i < 2 * h; ++i)
+        {
+            uint64_t sum = static_cast<uint64_t>(r[i]) + carry;
+            tmp[i] = static_cast<uint32_t>(sum);
+            carry = static_cast<uint32_t>(sum >> mpn::LIMB_BITS);
+        }
+        carry += mpn::cnd_add_n(add_t, tmp, tmp, t, 2 * h);
+        carry -= mpn::cnd_sub_n(add_t ^ 1u, tmp, tmp, t, 2 * h);
+
+        carry += mpn::add_n(r + h, r + h, tmp, 2 * h);
+        add_carry(r + 3 * h, 2 * n - 3 * h, carry);
+    }
+
+    size_t karatsuba_scratch(size_t n, size_t threshold)
+    {
+        if (n < threshold)
+            return 0;
+        size_t h = (n + 1) / 2;
+        return 4 * h + std::max(karatsuba_scratch(h, threshold), 2 * h);
+    }
+
+    // r[0..2n) = a[0..n) * b[0..n)
+    void karatsuba_mul(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n, uint32_t* scratch)
+    {
+        if (n < KARATSUBA_MUL_THRESHOLD)
+        {
+            mul_basecase(r, a, n, b, n);
+            return;
+        }
+        // a = a1 * B^h + a0, b likewise; the middle coefficient a0 * b1 + a1 * b0 is
+        // z0 + z2 - (a0 - a1) * (b0 - b1)
+        size_t h = (n + 1) / 2, l = n - h;
+        uint32_t* da = scratch;
+        uint32_t* db = da + h;
+        uint32_t* t = db + h;
+        uint32_t* rest = t + 2 * h;
+        uint32_t sa = abs_diff(da, a, h, a + h, l);
+        uint32_t sb = abs_diff(db, b, h, b + h, l);
+        karatsuba_mul(t, da, db, h, rest);
+        karatsuba_mul(r, a, b, h, rest);
+        karatsuba_mul(r + 2 * h, a + h, b + h, l, rest);
+        karatsuba_middle(r, n, h, t, sa ^ sb, rest);
+    }
+
+    // r[0..2n) = a[0..n)^2
+    void karatsuba_sqr(uint32_t* r, const uint32_t* a, size_t n, uint32_t* scratch)
+    {
+        if (n < KARATSUBA_SQR_THRESHOLD)
+        {
+            sqr_basecase(r, a, n);
+            return;
+        }
+        size_t h = (n + 1) / 2, l = n - h;
+        uint32_t* da = scratch;
+        uint32_t* t = da + 2 * h;
+        uint32_t* rest = t + 2 * h;
+        abs_diff(da, a, h, a + h, l);
+        karatsuba_sqr(t, da, h, rest);
+        karatsuba_sqr(r, a, h, rest);
+        karatsuba_sqr(r + 2 * h, a + h, l, rest);
+        karatsuba_middle(r, n, h, t, 0, rest);
+    }
+}
+
+void mpn::mul(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    if (bn < KARATSUBA_MUL_THRESHOLD)
+    {
+        mul_basecase(r, a, an, b, bn);
+        return;
+    }
+
+    scratch_vector scratch_storage;
+    scratch_storage.resize_uninitialized(karatsuba_scratch(bn, KARATSUBA_MUL_THRESHOLD) + 2 * bn);
+    uint32_t* scratch = scratch_storage.mutable_data();
+    karatsuba_mul(r, a, b, bn, scratch);
+
+    // an unbalanced product is a sum of bn x bn products (the last one possibly shorter) of a's chunks
+    uint32_t* chunk = scratch + karatsuba_scratch(bn, KARATSUBA_MUL_THRESHOLD);
+    for (size_t i = bn; i < an; i += bn)
+    {
+        size_t len = std::min(bn, an - i);
+        if (len == bn)
+            karatsuba_mul(chunk, a + i, b, bn, scratch);
+        else
+            mul(chunk, b, bn, a + i, len);
+        uint32_t carry = add_n(r + i, r + i, chunk, bn);
+        std::copy(chunk + bn, chunk + bn + len, r + i + bn);
+        add_carry(r + i + bn, len, carry);
+    }
+}
+
+void mpn::sqr(uint32_t* r, const uint32_t* a, size_t n)
+{
+    if (n < KARATSUBA_SQR_THRESHOLD)
+    {
+        sqr_basecase(r, a, n);
+        return;
+    }
+    scratch_vector scratch;
+    scratch.resize_uninitialized(karatsuba_scratch(n, KARATSUBA_SQR_THRESHOLD));
+    karatsuba_sqr(r, a, n, scratch.mutable_data());
+}
+
+uint32_t mpn::addmul(uint32_t* r, size_t rn, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    if (bn >= KARATSUBA_MUL_THRESHOLD)
+    {
+        // past the schoolbook range the rows lose to Karatsuba, so the product is formed apart and added once
+        scratch_vector product;
+        product.resize_uninitialized(an + bn);
+        mul(product.mutable_data(), a, an, b, bn);
+        return add(r, r, rn, product.cbegin(), an + bn);
+    }
+
+    uint32_t carry = 0;
+    for (size_t i = 0; i < bn; ++i)
+    {
+        // the high limb rarely carries further than one limb, so the propagation is kept inline
+        uint32_t high = addmul_1(r + i, a, an, b[i]);
+        size_t k = an + i;
+        for (; high && k < rn; ++k)
+        {
+            r[k] += high;
+            high = (r[k] < high);
+        }
+        carry += high;
+    }
+    return carry;
+}
+
+uint32_t mpn::submul(uint32_t* r, size_t rn, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    if (bn >= KARATSUBA_MUL_THRESHOLD)
+    {
+        scratch_vector product;
+        product.resize_uninitialized(an + bn);
+        mul(product.mutable_data(), a, an, b, bn);
+        return sub(r, r, rn, product.cbegin(), an + bn);
+    }
+
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < bn; ++i)
+    {
+        uint32_t high = submul_1(r + i, a, an, b[i]);
+        size_t k = an + i;
+        for (; high && k < rn; ++k)
+        {
+            uint32_t x = r[k];
+            r[k] = x - high;
+            high = (x < high);
+        }
+        borrow += high;
+    }
+    return borrow;
+}
+
+uint32_t mpn::neg(uint32_t* r, const uint32_t* a, size_t n)
+{
+    size_t i = 0;
+    for (; i < n && !a[i]; ++i)
+        r[i] = 0;
+    if (i == n)
+        return 0;
+    // -x == ~(x - 1): the lowest non-zero limb is negated, all higher ones are inverted
+    r[i] = ~a[i] + 1;
+    for (++i; i < n; ++i)
+        r[i] = ~a[i];
+    return 1;
+}
+
+uint32_t mpn::lshift(uint32_t* r, const uint32_t* a, size_t n, unsigned cnt)
+{
+    unsigned tnc = LIMB_BITS - cnt;
+    uint32_t out = a[n - 1] >> tnc;
+    size_t i = n - 1;
+#if defined(__SSE2__)
+    __m128i shl = _mm_cvtsi32_si128(static_cast<int>(cnt));
+    __m128i shr = _mm_cvtsi32_si128(static_cast<int>(tnc));
+    for (; i >= 4; i -= 4)
+    {
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i - 3));
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i - 4));
+        __m128i res = _mm_or_si128(_mm_sll_epi32(high, shl), _mm_srl_epi32(low, shr));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i - 3), res);
+    }
+#endif
+    for (; i > 0; --i)
+        r[i] = (a[i] << cnt) | (a[i - 1] >> tnc);
+    r[0] = a[0] << cnt;
+    return out;
+}
+
+uint32_t mpn::rshift(uint32_t* r, const uint32_t* a, size_t n, unsigned cnt)
+{
+    unsigned tnc = LIMB_BITS - cnt;
+    uint32_t out = a[0] << tnc;
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128i shr = _mm_cvtsi32_si128(static_cast<int>(cnt));
+    __m128i shl = _mm_cvtsi32_si128(static_cast<int>(tnc));
+    for (; i + 4 < n; i += 4)
+    {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 1));
+        __m128i res = _mm_or_si128(_mm_srl_epi32(low, shr), _mm_sll_epi32(high, shl));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), res);
+    }
+#endif
+    for (; i + 1 < n; ++i)
+        r[i] = (a[i] >> cnt) | (a[i + 1] << tnc);
+    r[n - 1] = a[n - 1] >> cnt;
+    return out;
+}
+
+int mpn::cmp(const uint32_t* a, const uint32_t* b, size_t n)
+{
+#if defined(__SSE2__)
+    // skip equal blocks of four limbs from the top
+    while (n >= 4)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + n - 4));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + n - 4));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(x, y)) != 0xFFFF)
+            break;
+        n -= 4;
+    }
+#endif
+    while (n-- > 0)
+    {
+        if (a[n] != b[n])
+            return a[n] < b[n] ? -1 : 1;
+    }
+    return 0;
+}
+
+int mpn::cmp(const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    if (an != bn)
+        return an < bn ? -1 : 1;
+    return cmp(a, b, an);
+}
+
+uint32_t mpn::divrem_1(uint32_t* q, const uint32_t* a, size_t n, uint32_t d)
+{
+    uint64_t rem = 0;
+    for (size_t i = n; i-- > 0;)
+    {
+        uint64_t cur = (rem << LIMB_BITS) | a[i];
+        q[i] = static_cast<uint32_t>(cur / d);
+        rem = cur % d;
+    }
+    return static_cast<uint32_t>(rem);
+}
+
+uint32_t mpn::mod_1(const uint32_t* a, size_t n, uint32_t d)
+{
+    uint64_t rem = 0;
+    for (size_t i = n; i-- > 0;)
+        rem = ((rem << LIMB_BITS) | a[i]) % d;
+    return static_cast<uint32_t>(rem);
+}
+
+void mpn::tdiv_qr(uint32_t* q, uint32_t* r, const uint32_t* a, size_t an, const uint32_t* d, size_t dn)
+{
+    // normalize so that the top bit of the divisor is set, then the trial quotient
+    // from the top two limbs is at most 2 too large
+    auto shift = static_cast<unsigned>(__builtin_clz(d[dn - 1]));
+
+    scratch_vector vn_storage, un_storage;
+    vn_storage.resize_uninitialized(dn);
+    un_storage.resize_uninitialized(an + 1);
+    uint32_t* vn = vn_storage.mutable_data();
+    uint32_t* un = un_storage.mutable_data();
+
+    if (shift)
+    {
+        lshift(vn, d, dn, shift);
+        un[an] = lshift(un, a, an, shift);
+    }
+    else
+    {
+        std::copy(d, d + dn, vn);
+        std::copy(a, a + an, un);
+        un[an] = 0;
+    }
+
+    uint64_t v1 = vn[dn - 1], v2 = vn[dn - 2];
+    for (size_t j = an - dn + 1; j-- > 0;)
+    {
+        uint64_t num = (static_cast<uint64_t>(un[j + dn]) << LIMB_BITS) | un[j + dn - 1];
+        uint64_t qhat = num / v1;
+        uint64_t rhat = num % v1;
+        while ((qhat >> LIMB_BITS) || qhat * v2 > ((rhat << LIMB_BITS) | un[j + dn - 2]))
+        {
+            --qhat;
+            rhat += v1;
+            if (rhat >> LIMB_BITS)
+                break;
+        }
+
+        uint32_t borrow = submul_1(un + j, vn, dn, static_cast<uint32_t>(qhat));
+        uint32_t top = un[j + dn];
+        un[j + dn] = top - borrow;
+        if (top < borrow)
+        {
+            // qhat was one too large
+            --qhat;
+            un[j + dn] += add_n(un + j, un + j, vn, dn);
+        }
+        q[j] = static_cast<uint32_t>(qhat);
+    }
+
+    if (shift)
+        rshift(r, un, dn, shift);
+    else
+        std::copy(un, un + dn, r);
+}
+
+uint32_t mpn::binvert_limb(uint32_t d)
+{
+    // d * d == 1 mod 8 for odd d; every Newton step x = x * (2 - d * x) doubles the correct low bits
+    uint32_t inv = d;
+    for (int i = 0; i < 4; ++i)
+        inv *= 2 - d * inv;
+    return inv;
+}
+
+void mpn::redc_1(uint32_t* r, uint32_t* t, const uint32_t* m, size_t n, uint32_t minv)
+{
+    // each pass adds the multiple of m that clears the lowest limb; that limb is then free to hold
+    // the pass's carry, which belongs n limbs higher and is added to the upper half in one go
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint32_t q = t[i] * minv;
+        t[i] = addmul_1(t + i, m, n, q);
+    }
+    // the sum is below 2m, so at most one subtraction is needed; it is always computed (into the upper
+    // half of t, which is free by then) and selected without a branch, keeping the reduction constant-time
+    uint32_t carry = add_n(r, t + n, t, n);
+    uint32_t borrow = sub_n(t + n, r, m, n);
+    cnd_copy(carry | (borrow ^ 1u), r, t + n, n);
+}
+
+uint32_t mpn::cnd_add_n(uint32_t cnd, uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n)
+{
+    uint32_t mask = 0u - (cnd != 0);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t sum = static_cast<uint64_t>(a[i]) + (b[i] & mask) + carry;
+        r[i] = static_cast<uint32_t>(sum);
+        carry = sum >> LIMB_BITS;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+uint32_t mpn::cnd_sub_n(uint32_t cnd, uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n)
+{
+    uint32_t mask = 0u - (cnd != 0);
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64_t diff = static_cast<uint64_t>(a[i]) - (b[i] & mask) - borrow;
+        r[i] = static_cast<uint32_t>(diff);
+        borrow = diff >> (2 * LIMB_BITS - 1);
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+void mpn::cnd_copy(uint32_t cnd, uint32_t* r, const uint32_t* a, size_t n)
+{
+    uint32_t mask = 0u - (cnd != 0);
+    for (size_t i = 0; i < n; ++i)
+        r[i] = (r[i] & ~mask) | (a[i] & mask);
+}
+
+void mpn::tabselect(uint32_t* r, const uint32_t* table, size_t n, size_t entries, size_t k)
+{
+    // every entry is read; the mask is all ones only for entry k
+    std::fill(r, r + n, 0);
+    for (size_t e = 0; e < entries; ++e, table += n)
+    {
+        size_t diff = e ^ k;
+        uint32_t mask = static_cast<uint32_t>(((diff | (0 - diff)) >> (sizeof(size_t) * 8 - 1)) - 1);
+        for (size_t i = 0; i < n; ++i)
+            r[i] |= table[i] & mask;
+    }
+}
+
+namespace
+{
+    // dst[0..k) = low k limbs of src[0..n) >> shift, 0 <= shift < LIMB_BITS, missing limbs are zero
+    void shifted_low_limbs(uint32_t* dst, size_t k, const uint32_t* src, size_t n, unsigned shift)
+    {
+        size_t m = std::min(n, k);
+        if (shift)
+        {
+            mpn::rshift(dst, src, m, shift);
+            if (m < n)
+                dst[m - 1] |= src[m] << (mpn::LIMB_BITS - shift);
+        }
+        else
+            std::copy(src, src + m, dst);
+        std::fill(dst + m, dst + k, 0);
+    }
+}
+
+void mpn::divexact(uint32_t* q, const uint32_t* a, size_t an, const uint32_t* d, size_t dn)
+{
+    size_t qn = an - dn + 1;
+
+    // a has at least as many trailing zeros as d: drop them from both, so that d is odd
+    size_t zeros = 0;
+    while (d[zeros] == 0)
+        ++zeros;
+    auto shift = static_cast<unsigned>(__builtin_ctz(d[zeros]));
+
+    // the quotient is below B^qn, so it is determined by the low qn limbs of a and d
+    size_t rn = qn, ln = std::min(dn - zeros, qn);
+    scratch_vector r_storage, d_storage;
+    r_storage.resize_uninitialized(rn);
+    d_storage.resize_uninitialized(ln);
+    uint32_t* r = r_storage.mutable_data();
+    uint32_t* dl = d_storage.mutable_data();
+    shifted_low_limbs(r, rn, a + zeros, an - zeros, shift);
+    shifted_low_limbs(dl, ln, d + zeros, dn - zeros, shift);
+
+    uint32_t inv = binvert_limb(dl[0]);
+    if (ln == 1)
+    {
+        // q_i is the unique limb that clears the lowest remaining limb; only the high part carries on
+        uint32_t divisor = dl[0], borrow = 0;
+        for (size_t i = 0; i < qn; ++i)
+        {
+            uint32_t x = r[i];
+            uint32_t qi = (x - borrow) * inv;
+            q[i] = qi;
+            borrow = static_cast<uint32_t>((static_cast<uint64_t>(qi) * divisor) >> LIMB_BITS) + (x < borrow);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < qn; ++i)
+    {
+        uint32_t qi = r[i] * inv;
+        q[i] = qi;
+        size_t len = std::min(ln, qn - i);
+        uint32_t borrow = submul_1(r + i, dl, len, qi);
+        for (size_t k = i + len; borrow && k < qn; ++k)
+        {
+            uint32_t x = r[k];
+            r[k] = x - borrow;
+            borrow = (x < borrow);
+        }
+    }
+}
+
+namespace
+{
+    // 64 bits of a[0..n) starting at bit shift, missing limbs are zero
+    uint64_t bits_at(const uint32_t* a, size_t n, size_t shift)
+    {
+        size_t i = shift / mpn::LIMB_BITS;
+        unsigned offset = shift % mpn::LIMB_BITS;
+        uint64_t limbs[3] = {0, 0, 0};
+        for (size_t k = 0; k < 3 && i + k < n; ++k)
+            limbs[k] = a[i + k];
+        uint64_t low = limbs[0] | (limbs[1] << mpn::LIMB_BITS);
+        if (offset == 0)
+            return low;
+        return (low >> offset) | (limbs[2] << (2 * mpn::LIMB_BITS - offset));
+    }
+
+    // r[0..n) = p * u - q * v, known to be non-negative and below B^n
+    void mul_sub(uint32_t* r, const uint32_t* u, uint32_t p, const uint32_t* v, uint32_t q, size_t n)
+    {
+        mpn::mul_1(r, u, n, p);
+        mpn::submul_1(r, v, n, q);
+    }
+}
+
+bool mpn::lehmer(lehmer_matrix& m, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    // x and y keep 62 bits, so x + A and y + C stay within int64_t for cofactors below 2^32
+    size_t bits = an * LIMB_BITS - __builtin_clz(a[an - 1]);
+    size_t shift = bits > 62 ? bits - 62 : 0;
+    auto x = static_cast<int64_t>(bits_at(a, an, shift));
+    auto y = static_cast<int64_t>(bits_at(b, bn, shift));
+
+    // magnitudes of Knuth's A, B, C, D (algorithm L); A and D are negative after an odd number of steps
+    const uint64_t limit = 0xffffffffu;
+    uint64_t ma = 1, mb = 0, mc = 0, md = 1;
+    bool odd = false;
+    for (;;)
+    {
+        int64_t sa = odd ? -static_cast<int64_t>(ma) : static_cast<int64_t>(ma);
+        int64_t sb = odd ? static_cast<int64_t>(mb) : -static_cast<int64_t>(mb);
+        int64_t sc = odd ? static_cast<int64_t>(mc) : -static_cast<int64_t>(mc);
+        int64_t sd = odd ? -static_cast<int64_t>(md) : static_cast<int64_t>(md);
+        if (y + sc <= 0 || y + sd <= 0 || x + sa < 0 || x + sb < 0)
+            break;
+        // the quotient of a / b lies between the two estimates, so it is known when they agree
+        int64_t q = (x + sa) / (y + sc);
+        if (q != (x + sb) / (y + sd))
+            break;
+
+        // signs alternate, so the magnitudes of A - qC and B - qD are sums
+        uint64_t nc, nd;
+        auto uq = static_cast<uint64_t>(q);
+        if (__builtin_mul_overflow(uq, mc, &nc) || __builtin_mul_overflow(uq, md, &nd))
+            break;
+        nc += ma;
+        nd += mb;
+        if (nc > limit || nd > limit)
+            break;
+
+        ma = mc;
+        mb = md;
+        mc = nc;
+        md = nd;
+        odd = !odd;
+        int64_t t = x - q * y;
+        x = y;
+        y = t;
+    }
+    if (mb == 0)
+        return false;
+    m.a = static_cast<uint32_t>(ma);
+    m.b = static_cast<uint32_t>(mb);
+    m.c = static_cast<uint32_t>(mc);
+    m.d = static_cast<uint32_t>(md);
+    m.odd = odd;
+    return true;
+}
+
+void mpn::lehmer_reduce(uint32_t* ra, uint32_t* rb, lehmer_matrix const& m, const uint32_t* a, const uint32_t* b,
+                        size_t n)
+{
+    if (m.odd)
+    {
+        mul_sub(ra, b, m.b, a, m.a, n);
+        mul_sub(rb, a, m.c, b, m.d, n);
+    }
+    else
+    {
+        mul_sub(ra, a, m.a, b, m.b, n);
+        mul_sub(rb, b, m.d, a, m.c, n);
+    }
+}
+
+void mpn::lehmer_cofactors(uint32_t* r0, uint32_t* r1, lehmer_matrix const& m, const uint32_t* s0,
+                           const uint32_t* s1, size_t n)
+{
+    r0[n] = mul_1(r0, s0, n, m.a);
+    r0[n] += addmul_1(r0, s1, n, m.b);
+    r1[n] = mul_1(r1, s0, n, m.c);
+    r1[n] += addmul_1(r1, s1, n, m.d);
+}
+
+uint64_t mpn::gcd_2(uint64_t a, uint64_t b)
+{
+    if (a == 0)
+        return b;
+    if (b == 0)
+        return a;
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    // a stays odd; every step removes the factors of two from the even difference
+    while (b != 0)
+    {
+        b >>= __builtin_ctzll(b);
+        if (a > b)
+            std::swap(a, b);
+        b -= a;
+    }
+    return a << shift;
+}
+
+uint32_t mpn::gcd_1(const uint32_t* a, size_t n, uint32_t b)
+{
+    return static_cast<uint32_t>(gcd_2(b, mod_1(a, n, b)));
+}
+
+size_t mpn::gcd(uint32_t* g, const uint32_t* a, size_t an, const uint32_t* b, size_t bn)
+{
+    if (bn == 1)
+    {
+        g[0] = gcd_1(a, an, b[0]);
+        return 1;
+    }
+
+    // (x, y) = (b, a mod b) first, then Lehmer steps on n-limb buffers, with a full division step
+    // whenever the leading bits do not determine a quotient
+    size_t n = bn;
+    scratch_vector buffer;
+    buffer.resize_uninitialized(4 * n + an + 1);
+    uint32_t* x = buffer.mutable_data();
+    uint32_t* y = x + n;
+    uint32_t* u = y + n;
+    uint32_t* v = u + n;
+    uint32_t* q = v + n;
+
+    std::copy(b, b + bn, x);
+    size_t xn = bn;
+    tdiv_qr(q, y, a, an, b, bn);
+    size_t yn = normalized_size(y, bn);
+
+    while (yn != 0)
+    {
+        if (xn <= 2)
+        {
+            // both fit in a word: binary GCD
+            uint64_t wx = x[0] | (xn > 1 ? static_cast<uint64_t>(x[1]) << LIMB_BITS : 0);
+            uint64_t wy = y[0] | (yn > 1 ? static_cast<uint64_t>(y[1]) << LIMB_BITS : 0);
+            uint64_t w = gcd_2(wx, wy);
+            g[0] = static_cast<uint32_t>(w);
+            g[1] = static_cast<uint32_t>(w >> LIMB_BITS);
+            return g[1] ? 2 : 1;
+        }
+        if (yn == 1)
+        {
+            g[0] = gcd_1(x, xn, y[0]);
+            return 1;
+        }
+
+        lehmer_matrix m;
+        if (lehmer(m, x, xn, y, yn))
+        {
+            std::fill(y + yn, y + xn, 0);
+            lehmer_reduce(u, v, m, x, y, xn);
+            std::swap(x, u);
+            std::swap(y, v);
+            yn = normalized_size(y, xn);
+            xn = normalized_size(x, xn);
+        }
+        else
+        {
+            tdiv_qr(q, u, x, xn, y, yn);
+            std::swap(x, y);
+            std::swap(y, u);
+            xn = yn;
+            yn = normalized_size(y, xn);
+        }
+    }
+    std::copy(x, x + xn, g);
+    return xn;
+}
+
+size_t mpn::normalized_size(const uint32_t* a, size_t n)
+{
+    while (n > 0 && a[n - 1] == 0)
+        --n;
+    return n;
+}
@@ -0,0 +1,122 @@
+#ifndef MPN_H
+#define MPN_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Low-level arithmetic on little-endian spans of 32-bit limbs, in the spirit of GMP's mpn layer.
+// Functions never allocate unless stated otherwise; sizes are in limbs. Destination spans may coincide
+// with a source span (r == a) but must not partially overlap it, unless stated otherwise.
+//
+// add_n, sub_n, mul_1, addmul_1, submul_1, mul, sqr, redc_1 and the cnd_ and tabselect functions run in
+// time that depends on the sizes only, never on the limb values; constant-time code is built from them.
+namespace mpn
+{
+    static const uint32_t LIMB_BITS = 32u;
+
+    // r[0..n) = a[0..n) + b[0..n), returns carry
+    uint32_t add_n(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n);
+    // r[0..n) = a[0..n) + b, returns carry
+    uint32_t add_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b);
+    // r[0..an) = a[0..an) + b[0..bn), an >= bn, returns carry
+    uint32_t add(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn);
+
+    // r[0..n) = a[0..n) - b[0..n), returns borrow
+    uint32_t sub_n(uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n);
+    // r[0..n) = a[0..n) - b, returns borrow
+    uint32_t sub_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b);
+    // r[0..an) = a[0..an) - b[0..bn), an >= bn, returns borrow
+    uint32_t sub(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn);
+
+    // r[0..n) = a[0..n) * b, returns the high limb
+    uint32_t mul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b);
+    // r[0..n) += a[0..n) * b, returns the high limb
+    uint32_t addmul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b);
+    // r[0..n) -= a[0..n) * b, returns the high limb to be subtracted
+    uint32_t submul_1(uint32_t* r, const uint32_t* a, size_t n, uint32_t b);
+
+    // r[0..an + bn) = a[0..an) * b[0..bn), an >= bn >= 1, r must not overlap a or b;
+    // Karatsuba above a threshold, which allocates scratch space
+    void mul(uint32_t* r, const uint32_t* a, size_t an, const uint32_t* b, size_t bn);
+    // r[0..2n) = a[0..n)^2, n >= 1, r must not overlap a; computes each cross product once,
+    // Karatsuba above a threshold
+    void sqr(uint32_t* r, const uint32_t* a, size_t n);
+    // r[0..rn) += a[0..an) * b[0..bn), rn >= an + bn, an >= bn >= 1, r must not overlap a or b; returns carry;
+    // from the Karatsuba threshold on, the product goes through mul in allocated scratch space
+    uint32_t addmul(uint32_t* r, size_t rn, const uint32_t* a, size_t an, const uint32_t* b, size_t bn);
+    // r[0..rn) -= a[0..an) * b[0..bn), same requirements as addmul; returns borrow
+    uint32_t submul(uint32_t* r, size_t rn, const uint32_t* a, size_t an, const uint32_t* b, size_t bn);
+
+    // r[0..n) = -a[0..n) modulo B^n, returns 0 when a is zero and 1 otherwise
+    uint32_t neg(uint32_t* r, const uint32_t* a, size_t n);
+
+    // r[0..n) = a[0..n) << cnt, 0 < cnt < LIMB_BITS, returns the bits shifted out; r >= a is allowed
+    uint32_t lshift(uint32_t* r, const uint32_t* a, size_t n, unsigned cnt);
+    // r[0..n) = a[0..n) >> cnt, 0 < cnt < LIMB_BITS, returns the bits shifted out (in the high bits); r <= a is allowed
+    uint32_t rshift(uint32_t* r, const uint32_t* a, size_t n, unsigned cnt);
+
+    // sign of a[0..n) - b[0..n), scanning from the most significant limb
+    int cmp(const uint32_t* a, const uint32_t* b, size_t n);
+    // sign of a[0..an) - b[0..bn), neither has leading zero limbs
+    int cmp(const uint32_t* a, size_t an, const uint32_t* b, size_t bn);
+
+    // q[0..n) = a[0..n) / d, returns a mod d; d != 0, q may be equal to a
+    uint32_t divrem_1(uint32_t* q, const uint32_t* a, size_t n, uint32_t d);
+    // a[0..n) mod d, d != 0
+    uint32_t mod_1(const uint32_t* a, size_t n, uint32_t d);
+
+    // q[0..an - dn + 1) = a / d, r[0..dn) = a mod d (Knuth's algorithm D);
+    // an >= dn >= 2, d[dn - 1] != 0, q and r must not overlap the inputs; allocates scratch space
+    void tdiv_qr(uint32_t* q, uint32_t* r, const uint32_t* a, size_t an, const uint32_t* d, size_t dn);
+
+    // q[0..an - dn + 1) = a / d when d divides a exactly (Jebelean's right-to-left exact division);
+    // an >= dn >= 1, d[dn - 1] != 0, q must not overlap the inputs; allocates scratch space
+    void divexact(uint32_t* q, const uint32_t* a, size_t an, const uint32_t* d, size_t dn);
+    // d^-1 mod 2^32 for odd d
+    uint32_t binvert_limb(uint32_t d);
+
+    // r[0..n) = t[0..2n) / B^n mod m (Montgomery reduction), minv = -m^-1 mod 2^32, m odd with m[n - 1] != 0;
+    // t < m * B^n, the result is fully reduced; t is destroyed, r is either t or does not overlap it
+    void redc_1(uint32_t* r, uint32_t* t, const uint32_t* m, size_t n, uint32_t minv);
+
+    // r[0..n) = a[0..n) + b[0..n) if cnd != 0, a otherwise; returns carry
+    uint32_t cnd_add_n(uint32_t cnd, uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n);
+    // r[0..n) = a[0..n) - b[0..n) if cnd != 0, a otherwise; returns borrow
+    uint32_t cnd_sub_n(uint32_t cnd, uint32_t* r, const uint32_t* a, const uint32_t* b, size_t n);
+    // r[0..n) = a[0..n) if cnd != 0, r is left as is otherwise
+    void cnd_copy(uint32_t cnd, uint32_t* r, const uint32_t* a, size_t n);
+    // r[0..n) = entry k of table, entries of n limbs each; reads the whole table, r must not overlap it
+    void tabselect(uint32_t* r, const uint32_t* table, size_t n, size_t entries, size_t k);
+
+    // One step of Lehmer's algorithm: the quotient sequence of a / b that is provably shared with the
+    // leading 62 bits of a and the same bits of b, folded into a matrix of single-limb cofactors. With
+    // A = a, D = d and B = -b, C = -c (signs flipped when odd is set), the reduced pair is
+    // (A * a + B * b, C * a + D * b), and the cofactors of the inputs transform the same way
+    struct lehmer_matrix
+    {
+        uint32_t a, b, c, d;
+        bool odd;
+    };
+    // m for a >= b, a[an - 1] != 0, bn <= an; returns false when not even one quotient is determined
+    bool lehmer(lehmer_matrix& m, const uint32_t* a, size_t an, const uint32_t* b, size_t bn);
+    // (ra, rb)[0..n) = m applied to (a, b)[0..n); ra and rb must not overlap the inputs
+    void lehmer_reduce(uint32_t* ra, uint32_t* rb, lehmer_matrix const& m, const uint32_t* a, const uint32_t* b,
+                       size_t n);
+    // (r0, r1)[0..n + 1) = m applied to the cofactor magnitudes (s0, s1)[0..n), whose signs alternate
+    // like the matrix entries'; r0 and r1 must not overlap the inputs
+    void lehmer_cofactors(uint32_t* r0, uint32_t* r1, lehmer_matrix const& m, const uint32_t* s0,
+                          const uint32_t* s1, size_t n);
+
+    // g = gcd(a, b), returns its size (at most bn); an >= bn >= 1, neither has leading zero limbs,
+    // g must not overlap the inputs; allocates scratch space
+    size_t gcd(uint32_t* g, const uint32_t* a, size_t an, const uint32_t* b, size_t bn);
+    // gcd(a[0..n), b) for b != 0
+    uint32_t gcd_1(const uint32_t* a, size_t n, uint32_t b);
+    // gcd(a, b) of two words (binary algorithm)
+    uint64_t gcd_2(uint64_t a, uint64_t b);
+
+    // size of a[0..n) without leading zero limbs, 0 for an all-zero span
+    size_t normalized_size(const uint32_t* a, size_t n);
+}
+
+#endif // MPN_H
@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "mpn.h"
+
+namespace
+{
+    std::vector<uint32_t> random_limbs(size_t n)
+    {
+        std::vector<uint32_t> result(n);
+        for (auto& x : result)
+            x = (static_cast<uint32_t>(rand()) << 16) ^ static_cast<uint32_t>(rand());
+        return result;
+    }
+}
+
+TEST(mpn, add_sub_n)
+{
+    for (size_t n = 1; n < 20; ++n)
+    {
+        std::vector<uint32_t> a = random_limbs(n), b = random_limbs(n), sum(n), diff(n);
+        uint32_t carry = mpn::add_n(sum.data(), a.data(), b.data(), n);
+        uint32_t borrow = mpn::sub_n(diff.data(), sum.data(), b.data(), n);
+        EXPECT_EQ(carry, borrow);
+        EXPECT_EQ(diff, a);
+    }
+}
+
+TEST(mpn, add_sub_1)
+{
+    std::vector<uint32_t> a = {UINT32_MAX, UINT32_MAX, 5}, r(3);
+    EXPECT_EQ(mpn::add_1(r.data(), a.data(), 3, 1), 0u);
+    EXPECT_EQ(r, std::vector<uint32_t>({0, 0, 6}));
+    EXPECT_EQ(mpn::sub_1(r.data(), r.data(), 3, 1), 0u);
+    EXPECT_EQ(r, a);
+    EXPECT_EQ(mpn::add_1(r.data(), a.data(), 2, 1), 1u);
+    EXPECT_EQ(mpn::sub_1(r.data(), r.data(), 2, 1), 1u);
+}
+
+TEST(mpn, mul_addmul_submul)
+{
+    for (size_t n = 1; n < 20; ++n)
+    {
+        std::vector<uint32_t> a = random_limbs(n), r = random_limbs(n), orig = r;
+        uint32_t b = random_limbs(1)[0];
+        uint32_t high = mpn::addmul_1(r.data(), a.data(), n, b);
+        EXPECT_EQ(mpn::submul_1(r.data(), a.data(), n, b), high);
+        EXPECT_EQ(r, orig);
+
+        std::vector<uint32_t> p(n), q(n);
+        uint32_t top = mpn::mul_1(p.data(), a.data(), n, b);
+        EXPECT_EQ(mpn::divrem_1(q.data(), p.data(), n, b), mpn::mod_1(p.data(), n, b));
+        if (top == 0)
+        {
+            EXPECT_EQ(q, a);
+        }
+    }
+}
+
+TEST(mpn, shifts)
+{
+    for (size_t n = 1; n < 20; ++n)
+        for (unsigned cnt = 1; cnt < mpn::LIMB_BITS; cnt += 5)
+        {
+            std::vector<uint32_t> a = random_limbs(n), r(n), back(n);
+            a.back() >>= cnt;
+            EXPECT_EQ(mpn::lshift(r.data(), a.data(), n, cnt), 0u);
+            EXPECT_EQ(mpn::rshift(back.data(), r.data(), n, cnt), 0u);
+            EXPECT_EQ(back, a);
+
+            // in place
+            std::vector<uint32_t> c = a;
+            mpn::lshift(c.data(), c.data(), n, cnt);
+            EXPECT_EQ(c, r);
+            mpn::rshift(c.data(), c.data(), n, cnt);
+            EXPECT_EQ(c, a);
+        }
+}
+
+TEST(mpn, cmp)
+{
+    for (size_t n = 1; n < 20; ++n)
+    {
+        std::vector<uint32_t> a = random_limbs(n), b = a;
+        EXPECT_EQ(mpn::cmp(a.data(), b.data(), n), 0);
+        size_t i = rand() % n;
+        b[i] ^= 1;
+        EXPECT_EQ(mpn::cmp(a.data(), b.data(), n), a[i] < b[i] ? -1 : 1);
+        EXPECT_EQ(mpn::cmp(a.data(), n, b.data(), n + 1), -1);
+    }
+}
+
+TEST(mpn, tdiv_qr)
+{
+    for (size_t itn = 0; itn < 1000; ++itn)
+    {
+        size_t dn = 2 + rand() % 8, qn = 1 + rand() % 8;
+        std::vector<uint32_t> d = random_limbs(dn), q = random_limbs(qn), rem = random_limbs(dn);
+        if (rand() % 2)
+            d.back() = 1 + rand() % 4;
+        if (d.back() == 0)
+            d.back() = 1;
+        if (mpn::cmp(rem.data(), d.data(), dn) >= 0)
+            rem.back() = 0;
+        if (mpn::cmp(rem.data(), d.data(), dn) >= 0)
+            std::fill(rem.begin(), rem.end(), 0);
+
+        // a = q * d + rem
+        std::vector<uint32_t> a(qn + dn);
+        if (qn >= dn)
+            mpn::mul(a.data(), q.data(), qn, d.data(), dn);
+        else
+            mpn::mul(a.data(), d.data(), dn, q.data(), qn);
+        ASSERT_EQ(mpn::add(a.data(), a.data(), qn + dn, rem.data(), dn), 0u);
+
+        std::vector<uint32_t> q2(qn + 1), r2(dn);
+        mpn::tdiv_qr(q2.data(), r2.data(), a.data(), qn + dn, d.data(), dn);
+        ASSERT_EQ(q2.back(), 0u);
+        q2.pop_back();
+        ASSERT_EQ(q2, q);
+        ASSERT_EQ(r2, rem);
+    }
+}
+
+TEST(mpn, addmul_submul)
+{
+    for (size_t itn = 0; itn < 1000; ++itn)
+    {
+        size_t an = 1 + rand() % 8, bn = 1 + rand() % an, rn = an + bn + rand() % 3;
+        std::vector<uint32_t> a = random_limbs(an), b = random_limbs(bn), r = random_limbs(rn), orig = r;
+
+        std::vector<uint32_t> product(an + bn), expected = r;
+        mpn::mul(product.data(), a.data(), an, b.data(), bn);
+        uint32_t carry = mpn::add(expected.data(), expected.data(), rn, product.data(), an + bn);
+
+        ASSERT_EQ(mpn::addmul(r.data(), rn, a.data(), an, b.data(), bn), carry);
+        ASSERT_EQ(r, expected);
+        ASSERT_EQ(mpn::submul(r.data(), rn, a.data(), an, b.data(), bn), carry);
+        ASSERT_EQ(r, orig);
+    }
+}
+
+TEST(mpn, neg)
+{
+    std::vector<uint32_t> zero(3, 0), r(3);
+    EXPECT_EQ(mpn::neg(r.data(), zero.data(), 3), 0u);
+    EXPECT_EQ(r, zero);
+
+    std::vector<uint32_t> a = {0, 1, 0};
+    EXPECT_EQ(mpn::neg(r.data(), a.data(), 3), 1u);
+    EXPECT_EQ(r, std::vector<uint32_t>({0, UINT32_MAX, UINT32_MAX}));
+    std::vector<uint32_t> sum(3);
+    EXPECT_EQ(mpn::add_n(sum.data(), r.data(), a.data(), 3), 1u);
+    EXPECT_EQ(sum, zero);
+}
+
+TEST(mpn, binvert_limb)
+{
+    for (size_t itn = 0; itn < 1000; ++itn)
+    {
+        uint32_t d = random_limbs(1)[0] | 1u;
+        EXPECT_EQ(d * mpn::binvert_limb(d), 1u);
+    }
+}
+
+TEST(mpn, redc_1)
+{
+    for (size_t itn = 0; itn < 1000; ++itn)
+    {
+        size_t n = 1 + rand() % 8;
+        std::vector<uint32_t> m = random_limbs(n), a = random_limbs(n), r(n);
+        m[0] |= 1u;
+        if (m.back() == 0)
+            m.back() = 1;
+        if (mpn::cmp(a.data(), m.data(), n) >= 0)
+            mpn::sub_n(a.data(), a.data(), m.data(), n);
+        if (mpn::cmp(a.data(), m.data(), n) >= 0)
+            std::fill(a.begin(), a.end(), 0);
+
+        // t = a * B^n, so the reduction gives back a
+        std::vector<uint32_t> t(2 * n, 0);
+        std::copy(a.begin(), a.end(), t.begin() + n);
+        mpn::redc_1(r.data(), t.data(), m.data(), n, -mpn::binvert_limb(m[0]));
+        EXPECT_EQ(r, a);
+
+        // redc(t) * B^n == t mod m
+        t = random_limbs(2 * n);
+        t.back() = 0;
+        if (mpn::cmp(t.data() + n, m.data(), n) >= 0)
+            std::fill(t.begin() + n, t.end(), 0);
+        std::vector<uint32_t> t_copy = t, lhs(2 * n, 0), q(n + 1), rem_lhs(n), rem_t(n);
+        mpn::redc_1(r.data(), t.data(), m.data(), n, -mpn::binvert_limb(m[0]));
+        EXPECT_LT(mpn::cmp(r.data(), m.data(), n), 0);
+        std::copy(r.begin(), r.end(), lhs.begin() + n);
+        if (n == 1)
+        {
+            EXPECT_EQ(mpn::mod_1(lhs.data(), 2, m[0]), mpn::mod_1(t_copy.data(), 2, m[0]));
+            continue;
+        }
+        mpn::tdiv_qr(q.data(), rem_lhs.data(), lhs.data(), 2 * n, m.data(), n);
+        mpn::tdiv_qr(q.data(), rem_t.data(), t_copy.data(), 2 * n, m.data(), n);
+        EXPECT_EQ(rem_lhs, rem_t);
+    }
+}
+
+TEST(mpn, conditional)
+{
+    for (size_t itn = 0; itn < 200; ++itn)
+    {
+        size_t n = 1 + rand() % 10;
+        std::vector<uint32_t> a = random_limbs(n), b = random_limbs(n), r(n), expected(n);
+        uint32_t cnd = rand() % 2 ? random_limbs(1)[0] | 1u : 0u;
+
+        uint32_t carry = mpn::cnd_add_n(cnd, r.data(), a.data(), b.data(), n);
+        uint32_t expected_carry = cnd ? mpn::add_n(expected.data(), a.data(), b.data(), n) : 0;
+        if (!cnd)
+            expected = a;
+        EXPECT_EQ(r, expected);
+        EXPECT_EQ(carry, expected_carry);
+
+        uint32_t borrow = mpn::cnd_sub_n(cnd, r.data(), a.data(), b.data(), n);
+        uint32_t expected_borrow = cnd ? mpn::sub_n(expected.data(), a.data(), b.data(), n) : 0;
+        if (!cnd)
+            expected = a;
+        EXPECT_EQ(r, expected);
+        EXPECT_EQ(borrow, expected_borrow);
+
+        r = b;
+        mpn::cnd_copy(cnd, r.data(), a.data(), n);
+        EXPECT_EQ(r, cnd ? a : b);
+    }
+}
+
+TEST(mpn, tabselect)
+{
+    size_t n = 3, entries = 7;
+    std::vector<uint32_t> table = random_limbs(n * entries), r(n);
+    for (size_t k = 0; k < entries; ++k)
+    {
+        mpn::tabselect(r.data(), table.data(), n, entries, k);
+        EXPECT_TRUE(std::equal(r.begin(), r.end(), table.begin() + k * n));
+    }
+}
+
+TEST(mpn, gcd)
+{
+    for (size_t itn = 0; itn < 300; ++itn)
+    {
+        uint64_t x = (static_cast<uint64_t>(random_limbs(1)[0]) << 32) | random_limbs(1)[0];
+        uint64_t y = random_limbs(1)[0] >> (rand() % 32);
+        uint64_t expected = x, other = y;
+        while (other != 0)
+        {
+            uint64_t r = expected % other;
+            expected = other;
+            other = r;
+        }
+        EXPECT_EQ(mpn::gcd_2(x, y), expected);
+        EXPECT_EQ(mpn::gcd_2(y, x), expected);
+        if (y != 0)
+        {
+            uint32_t limbs[2] = {static_cast<uint32_t>(x), static_cast<uint32_t>(x >> 32)};
+            EXPECT_EQ(mpn::gcd_1(limbs, 2, static_cast<uint32_t>(y)), mpn::gcd_2(x, static_cast<uint32_t>(y)));
+        }
+
+        // the gcd divides both operands and leaves coprime cofactors
+        size_t an = 2 + rand() % 20, bn = 2 + rand() % (an - 1);
+        std::vector<uint32_t> a = random_limbs(an), b = random_limbs(bn);
+        a.back() |= 1u;
+        b.back() |= 1u;
+        std::vector<uint32_t> g(bn), q(an + 1), r(an);
+        size_t gn = mpn::gcd(g.data(), a.data(), an, b.data(), bn);
+        ASSERT_GE(gn, 1u);
+        ASSERT_NE(g[gn - 1], 0u);
+        if (gn == 1)
+        {
+            EXPECT_EQ(mpn::mod_1(a.data(), an, g[0]), 0u);
+            EXPECT_EQ(mpn::mod_1(b.data(), bn, g[0]), 0u);
+            continue;
+        }
+        std::vector<uint32_t> ca(an), cb(bn), h(bn);
+        mpn::tdiv_qr(ca.data(), r.data(), a.data(), an, g.data(), gn);
+        EXPECT_EQ(mpn::normalized_size(r.data(), gn), 0u);
+        mpn::tdiv_qr(cb.data(), r.data(), b.data(), bn, g.data(), gn);
+        EXPECT_EQ(mpn::normalized_size(r.data(), gn), 0u);
+        size_t can = mpn::normalized_size(ca.data(), an - gn + 1), cbn = mpn::normalized_size(cb.data(), bn - gn + 1);
+        size_t hn = can >= cbn ? mpn::gcd(h.data(), ca.data(), can, cb.data(), cbn)
+                               : mpn::gcd(h.data(), cb.data(), cbn, ca.data(), can);
+        EXPECT_EQ(hn, 1u);
+        EXPECT_EQ(h[0], 1u);
+    }
+}
+
+TEST(mpn, mul_sqr_large)
+{
+    // sizes around and well above the Karatsuba thresholds, checked against row-by-row products
+    for (size_t itn = 0; itn < 60; ++itn)
+    {
+        size_t bn = 20 + rand() % 200, an = bn + (rand() % 2 ? rand() % 500 : 0);
+        std::vector<uint32_t> a = random_limbs(an), b = random_limbs(bn);
+        if (rand() % 4 == 0)
+            std::fill(a.begin(), a.begin() + an / 2, 0xffffffffu);
+        std::vector<uint32_t> r(an + bn), expected(an + bn, 0);
+        for (size_t i = 0; i < bn; ++i)
+            expected[an + i] = mpn::addmul_1(expected.data() + i, a.data(), an, b[i]);
+        mpn::mul(r.data(), a.data(), an, b.data(), bn);
+        ASSERT_EQ(r, expected);
+
+        std::vector<uint32_t> square(2 * an), expected_square(2 * an, 0);
+        for (size_t i = 0; i < an; ++i)
+            expected_square[an + i] = mpn::addmul_1(expected_square.data() + i, a.data(), an, a[i]);
+        mpn::sqr(square.data(), a.data(), an);
+        ASSERT_EQ(square, expected_square);
+    }
+}
+
+TEST(mpn, addmul_submul_large)
+{
+    // from the Karatsuba threshold on, the product is formed apart and folded in with one add or sub
+    for (size_t itn = 0; itn < 40; ++itn)
+    {
+        size_t bn = 40 + rand() % 200, an = bn + rand() % 300, rn = an + bn + rand() % 3;
+        std::vector<uint32_t> a = random_limbs(an), b = random_limbs(bn), r = random_limbs(rn);
+        if (rand() % 4 == 0)
+            std::fill(r.begin(), r.end(), 0xffffffffu);
+        std::vector<uint32_t> orig = r;
+
+        std::vector<uint32_t> product(an + bn, 0), expected = r;
+        for (size_t i = 0; i < bn; ++i)
+            product[an + i] = mpn::addmul_1(product.data() + i, a.data(), an, b[i]);
+        uint32_t carry = mpn::add(expected.data(), expected.data(), rn, product.data(), an + bn);
+
+        ASSERT_EQ(mpn::addmul(r.data(), rn, a.data(), an, b.data(), bn), carry);
+        ASSERT_EQ(r, expected);
+        ASSERT_EQ(mpn::submul(r.data(), rn, a.data(), an, b.data(), bn), carry);
+        ASSERT_EQ(r, orig);
+    }
+}
+
+TEST(mpn, divexact)
+{
+    for (size_t itn = 0; itn < 1000; ++itn)
+    {
+        size_t dn = 1 + rand() % 6, qn = 1 + rand() % 8;
+        std::vector<uint32_t> d = random_limbs(dn), q = random_limbs(qn);
+        if (d.back() == 0)
+            d.back() = 1;
+        if (q.back() == 0)
+            q.back() = 1;
+        if (dn > 1 && rand() % 2)
+            d[0] = 0;
+
+        std::vector<uint32_t> a(qn + dn);
+        if (qn >= dn)
+            mpn::mul(a.data(), q.data(), qn, d.data(), dn);
+        else
+            mpn::mul(a.data(), d.data(), dn, q.data(), qn);
+        size_t an = mpn::normalized_size(a.data(), a.size());
+
+        std::vector<uint32_t> q2(an - dn + 1);
+        mpn::divexact(q2.data(), a.data(), an, d.data(), dn);
+        q2.resize(qn, 0);
+        ASSERT_EQ(q2, q);
+    }
+}
+
+TEST(mpn, sqr)
+{
+    for (size_t n = 1; n < 40; ++n)
+    {
+        std::vector<uint32_t> a = random_limbs(n), sq(2 * n), prod(2 * n);
+        if (n % 3 == 0)
+            std::fill(a.begin(), a.end(), UINT32_MAX);
+        mpn::sqr(sq.data(), a.data(), n);
+        mpn::mul(prod.data(), a.data(), n, a.data(), n);
+        ASSERT_EQ(sq, prod);
+    }
+}
@@ -3,35 +3,54 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <climits>
+#include <cstring>
 #include <memory>
+#include <initializer_list>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <stdexcept>
 
-class optimized_vector
+// heap representation shared by all inline capacities
+struct optimized_vector_big_storage
 {
-    struct big_vector
-    {
-        size_t capacity;
-        std::shared_ptr <uint32_t> data;
+    size_t capacity;
+    std::shared_ptr <uint32_t> data;
+
+    optimized_vector_big_storage(size_t capacity, std::shared_ptr<uint32_t> data);
+    optimized_vector_big_storage(optimized_vector_big_storage const &other);
+
+    uint32_t* begin();
+    const uint32_t* begin() const;
+    uint32_t* end();
+    const uint32_t* end() const;
 
-        big_vector(size_t capacity, std::shared_ptr<uint32_t> data);
-        big_vector(big_vector const &other);
+    const uint32_t& operator[](size_t idx) const;
+    uint32_t& operator[](size_t idx);
 
-        uint32_t* begin();
-        const uint32_t* begin() const;
-        uint32_t* end();
-        const uint32_t* end() const;
+    //makes object unique
+    void detach(size_t useful_data);
 
-        const uint32_t& operator[](size_t idx) const;
-        uint32_t& operator[](size_t idx);
+    void guarantee_capacity(size_t cap);
+};
 
-        //makes object unique
-        void detach(size_t useful_data);
+// inline capacity that costs no space over the heap representation
+static const size_t OPTIMIZED_VECTOR_DEFAULT_SMALL_SIZE = sizeof(optimized_vector_big_storage) / sizeof(uint32_t);
 
-        void guarantee_capacity(size_t cap);
-    };
+template <size_t SMALL_OBJECT_SIZE>
+class basic_optimized_vector
+{
+    typedef optimized_vector_big_storage big_vector;
 
-    static const size_t SMALL_OBJECT_SIZE = sizeof(big_vector) / sizeof(uint32_t);
+    static_assert(SMALL_OBJECT_SIZE > 0, "inline capacity must be positive");
 
-    size_t siz;
+    // once on the heap, the vector returns to inline storage only when it shrinks to this size,
+    // so that sizes oscillating around SMALL_OBJECT_SIZE don't copy limbs back and forth
+    static const size_t SHRINK_TO_SMALL_SIZE = SMALL_OBJECT_SIZE / 2;
+
+    size_t siz : sizeof(size_t) * CHAR_BIT - 1;
+    size_t big : 1;
     union
     {
         uint32_t small_data[SMALL_OBJECT_SIZE];
@@ -44,36 +63,372 @@ private:
     void to_small();
 
 public:
-    optimized_vector();
-    optimized_vector(size_t n);
-    optimized_vector(size_t n, uint32_t val);
+    basic_optimized_vector();
+    basic_optimized_vector(size_t n);
+    basic_optimized_vector(size_t n, uint32_t val);
+
+    basic_optimized_vector(basic_optimized_vector const& other);
+    basic_optimized_vector(std::initializer_list<uint32_t> data);
 
-    optimized_vector(optimized_vector const& other);
-    optimized_vector(std::initializer_list<uint32_t> data);
+    template <typename InputIt,
+              typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    basic_optimized_vector(InputIt first, InputIt last);
 
-    ~optimized_vector();
+    ~basic_optimized_vector();
 
     const uint32_t& operator[](size_t idx) const;
     uint32_t& operator[](size_t idx);
 
-    optimized_vector& operator=(optimized_vector const &other);
-    void swap(optimized_vector& other) noexcept;
+    basic_optimized_vector& operator=(basic_optimized_vector const &other);
+    void swap(basic_optimized_vector& other) noexcept;
 
     void push_back(uint32_t const &val);
     void pop_back();
     const uint32_t& back() const;
     uint32_t& back();
 
+    // non-const begin()/end() detach, like every other mutable access
     uint32_t* begin();
     const uint32_t* begin() const;
     uint32_t* end();
     const uint32_t* end() const;
+    const uint32_t* cbegin() const;
+    const uint32_t* cend() const;
+
+    // detaches once and gives raw access to all size() limbs;
+    // the pointer is valid until the next size-changing call
+    uint32_t* mutable_data();
 
     void resize(size_t n);
+    // like resize, but new elements are left uninitialized
+    void resize_uninitialized(size_t n);
+
+    void assign(size_t n, uint32_t val);
+    // [first, last) must not point into this vector
+    template <typename InputIt,
+              typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type>
+    void assign(InputIt first, InputIt last);
+
     size_t size() const;
     void detach();
 };
 
-void swap(optimized_vector &a, optimized_vector& b);
+typedef basic_optimized_vector<OPTIMIZED_VECTOR_DEFAULT_SMALL_SIZE> optimized_vector;
+
+template <size_t N>
+void swap(basic_optimized_vector<N> &a, basic_optimized_vector<N>& b)
+{
+    a.swap(b);
+}
+
+// ===================================== basic_optimized_vector ================================================
+
+
+template <size_t N>
+basic_optimized_vector<N>::basic_optimized_vector() :
+        siz(0),
+        big(false)
+{}
+
+template <size_t N>
+basic_optimized_vector<N>::basic_optimized_vector(size_t n) :
+        siz(n),
+        big(n > N)
+{
+    // n <= N spelled out rather than read back from the bitfield, so the loop is seen to stay in bounds
+    if (n <= N)
+        for (size_t i = 0; i < n; ++i)
+            small_data[i] = 0;
+    else
+    {
+        new(&data) big_vector(n, std::shared_ptr<uint32_t>(new uint32_t[n](), std::default_delete<uint32_t[]>()));
+    }
+}
+
+template <size_t N>
+basic_optimized_vector<N>::basic_optimized_vector(size_t n, uint32_t val) :
+        siz(n),
+        big(n > N)
+{
+    if (n <= N)
+        for (size_t i = 0; i < n; ++i)
+            small_data[i] = val;
+    else
+    {
+        new(&data) big_vector(n, std::shared_ptr<uint32_t>(new uint32_t[n], std::default_delete<uint32_t[]>()));
+        for (size_t i = 0; i < n; ++i)
+            data.begin()[i] = val;
+    }
+}
+
+template <size_t N>
+basic_optimized_vector<N>::basic_optimized_vector(basic_optimized_vector const &other) :
+        siz(other.siz),
+        big(other.big)
+{
+    if (is_small())
+        std::copy(other.small_data, other.small_data + N, small_data);
+    else
+    {
+        new(&data) big_vector(other.data.capacity, other.data.data);
+    }
+}
+
+template <size_t N>
+basic_optimized_vector<N>::basic_optimized_vector(std::initializer_list<uint32_t> init_data) :
+        siz(init_data.size()),
+        big(init_data.size() > N)
+{
+    if (is_small())
+        std::copy(init_data.begin(), init_data.end(), small_data);
+    else
+    {
+        new(&data) big_vector(init_data.size(),
+                              std::shared_ptr<uint32_t>(new uint32_t[init_data.size()],
+                                                        std::default_delete<uint32_t[]>()));
+        std::copy(init_data.begin(), init_data.end(), data.begin());
+    }
+}
+
+template <size_t N>
+template <typename InputIt, typename>
+basic_optimized_vector<N>::basic_optimized_vector(InputIt first, InputIt last) :
+        siz(0),
+        big(false)
+{
+    resize_uninitialized(static_cast<size_t>(std::distance(first, last)));
+    std::copy(first, last, mutable_data());
+}
+
+template <size_t N>
+basic_optimized_vector<N>::~basic_optimized_vector()
+{
+    if (!is_small())
+    {
+        data.~big_vector();
+    }
+}
+
+template <size_t N>
+bool basic_optimized_vector<N>::is_small() const
+{
+    return !big;
+}
+
+template <size_t N>
+const uint32_t& basic_optimized_vector<N>::operator[](size_t idx) const
+{
+    return (is_small() ? small_data[idx] : data[idx]);
+}
+
+template <size_t N>
+uint32_t& basic_optimized_vector<N>::operator[](size_t idx)
+{
+    detach();
+    if (is_small())
+        return small_data[idx];
+    return data[idx];
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::swap(basic_optimized_vector &other) noexcept
+{
+    char tmp[sizeof(basic_optimized_vector)];
+    memcpy(&tmp, static_cast<void*>(this), sizeof(basic_optimized_vector));
+    memcpy(static_cast<void*>(this), static_cast<void*>(&other), sizeof(basic_optimized_vector));
+    memcpy(static_cast<void*>(&other), &tmp, sizeof(basic_optimized_vector));
+}
+
+template <size_t N>
+basic_optimized_vector<N>& basic_optimized_vector<N>::operator=(basic_optimized_vector const &other)
+{
+    basic_optimized_vector tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::detach()
+{
+    if (!is_small())
+        data.detach(siz);
+}
+
+template <size_t N>
+size_t basic_optimized_vector<N>::size() const
+{
+    return siz;
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::to_big()
+{
+    size_t capacity = std::max(N + 2, static_cast<size_t>(siz) * 2);
+
+    std::shared_ptr<uint32_t> ptr(new uint32_t[capacity], std::default_delete<uint32_t[]>());
+    std::copy(small_data, small_data + siz, ptr.get());
+    new(&data) big_vector(capacity, ptr);
+    big = true;
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::to_small()
+{
+    uint32_t tmp[N];
+    std::move(data.begin(), data.begin() + siz, tmp);
+    data.data.~shared_ptr<uint32_t>();
+    std::move(tmp, tmp + N, small_data);
+    big = false;
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::push_back(uint32_t const &val)
+{
+    if (is_small())
+    {
+        if (siz < N)
+        {
+            small_data[siz] = val;
+            ++siz;
+            return;
+        }
+        to_big();
+    }
+    else
+        data.detach(siz);
+    data.guarantee_capacity(siz + 1);
+    data[siz] = val;
+    ++siz;
+}
+
+template <size_t N>
+const uint32_t& basic_optimized_vector<N>::back() const
+{
+    if (siz == 0)
+        throw std::runtime_error("back() is not allowed in empty vector");
+    if (is_small())
+        return small_data[siz - 1];
+    return data[siz - 1];
+}
+
+template <size_t N>
+uint32_t& basic_optimized_vector<N>::back()
+{
+    if (siz == 0)
+        throw std::runtime_error("back() is not allowed in empty vector");
+    return mutable_data()[siz - 1];
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::pop_back()
+{
+    --siz;
+    if (!is_small() && siz <= SHRINK_TO_SMALL_SIZE)
+        to_small();
+}
+
+template <size_t N>
+const uint32_t* basic_optimized_vector<N>::begin() const
+{
+    if (is_small())
+        return small_data;
+    return data.begin();
+}
+
+template <size_t N>
+uint32_t* basic_optimized_vector<N>::begin()
+{
+    return mutable_data();
+}
+
+template <size_t N>
+const uint32_t* basic_optimized_vector<N>::end() const
+{
+    return begin() + siz;
+}
+
+template <size_t N>
+uint32_t* basic_optimized_vector<N>::end()
+{
+    return mutable_data() + siz;
+}
+
+template <size_t N>
+const uint32_t* basic_optimized_vector<N>::cbegin() const
+{
+    return begin();
+}
+
+template <size_t N>
+const uint32_t* basic_optimized_vector<N>::cend() const
+{
+    return end();
+}
+
+template <size_t N>
+uint32_t* basic_optimized_vector<N>::mutable_data()
+{
+    if (is_small())
+        return small_data;
+    data.detach(siz);
+    return data.begin();
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::resize(size_t n)
+{
+    size_t old_size = siz;
+    resize_uninitialized(n);
+    if (n > old_size)
+    {
+        uint32_t* d = mutable_data();
+        std::fill(d + old_size, d + n, 0);
+    }
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::resize_uninitialized(size_t n)
+{
+    if (is_small())
+    {
+        if (n > N)
+        {
+            to_big();
+            data.guarantee_capacity(n);
+        }
+    }
+    else
+    {
+        if (n <= SHRINK_TO_SMALL_SIZE)
+        {
+            siz = n;
+            to_small();
+        }
+        else if (n > siz)
+        {
+            data.detach(siz);
+            data.guarantee_capacity(n);
+        }
+    }
+    siz = n;
+}
+
+template <size_t N>
+void basic_optimized_vector<N>::assign(size_t n, uint32_t val)
+{
+    resize_uninitialized(n);
+    uint32_t* d = mutable_data();
+    std::fill(d, d + n, val);
+}
+
+template <size_t N>
+template <typename InputIt, typename>
+void basic_optimized_vector<N>::assign(InputIt first, InputIt last)
+{
+    resize_uninitialized(static_cast<size_t>(std::distance(first, last)));
+    std::copy(first, last, mutable_data());
+}
+
+extern template class basic_optimized_vector<OPTIMIZED_VECTOR_DEFAULT_SMALL_SIZE>;
 
 #endif //OPTIMIZED_VECTOR_H
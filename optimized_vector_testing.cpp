@@ -324,4 +324,128 @@ TEST(vector, big_big_resize)
     ASSERT_EQ(v[BIG_SIZE - 1], VAL);
     ASSERT_EQ(v[BIG_SIZE], 0u);
     ASSERT_EQ(v.back(), 0u);
-}
\ No newline at end of file
+}
+
+TEST(vector, big_size_t_ctor_zeroes)
+{
+    optimized_vector v(BIG_SIZE);
+    for (size_t i = 0; i < BIG_SIZE; ++i)
+        ASSERT_EQ(v[i], 0u);
+}
+
+TEST(vector, range_ctor)
+{
+    std::vector<uint32_t> src(BIG_SIZE);
+    for (size_t i = 0; i < BIG_SIZE; ++i)
+        src[i] = i;
+    optimized_vector v(src.begin(), src.end());
+    ASSERT_EQ(v.size(), BIG_SIZE);
+    for (size_t i = 0; i < BIG_SIZE; ++i)
+        ASSERT_EQ(v[i], i);
+
+    optimized_vector w(src.data(), src.data() + SMALL_SIZE);
+    ASSERT_EQ(w.size(), SMALL_SIZE);
+    ASSERT_EQ(w[0], 0u);
+}
+
+TEST(vector, assign)
+{
+    optimized_vector v(SMALL_SIZE, 1);
+    v.assign(BIG_SIZE, VAL);
+    ASSERT_EQ(v.size(), BIG_SIZE);
+    for (size_t i = 0; i < BIG_SIZE; ++i)
+        ASSERT_EQ(v[i], VAL);
+
+    uint32_t src[] = {3, 4};
+    v.assign(src, src + 2);
+    ASSERT_EQ(v.size(), 2u);
+    ASSERT_EQ(v[0], 3u);
+    ASSERT_EQ(v[1], 4u);
+}
+
+TEST(vector, assign_detaches)
+{
+    optimized_vector a(BIG_SIZE, 1);
+    optimized_vector b(a);
+    b.assign(BIG_SIZE, 2);
+    ASSERT_EQ(a[0], 1u);
+    ASSERT_EQ(b[0], 2u);
+}
+
+TEST(vector, resize_uninitialized)
+{
+    optimized_vector v(SMALL_SIZE, VAL);
+    v.resize_uninitialized(BIG_SIZE);
+    ASSERT_EQ(v.size(), BIG_SIZE);
+    ASSERT_EQ(v[0], VAL);
+    v.resize_uninitialized(SMALL_SIZE);
+    ASSERT_EQ(v.size(), SMALL_SIZE);
+    ASSERT_EQ(v[0], VAL);
+}
+
+TEST(vector, push_back_after_copy)
+{
+    optimized_vector a(BIG_SIZE, 1);
+    optimized_vector b(a);
+    a.push_back(2);
+    b.push_back(3);
+    ASSERT_EQ(a.back(), 2u);
+    ASSERT_EQ(b.back(), 3u);
+}
+
+TEST(vector, begin_detaches)
+{
+    optimized_vector a(BIG_SIZE, 1);
+    optimized_vector b(a);
+    *b.begin() = 2;
+    ASSERT_EQ(a[0], 1u);
+    ASSERT_EQ(b[0], 2u);
+}
+
+TEST(vector, mutable_data)
+{
+    optimized_vector a(BIG_SIZE, 1);
+    optimized_vector b(a);
+    uint32_t* d = b.mutable_data();
+    for (size_t i = 0; i < BIG_SIZE; ++i)
+        d[i] = i;
+    for (size_t i = 0; i < BIG_SIZE; ++i)
+    {
+        ASSERT_EQ(a[i], 1u);
+        ASSERT_EQ(b[i], i);
+    }
+    ASSERT_EQ(a.cbegin() + BIG_SIZE, a.cend());
+}
+
+TEST(vector, custom_small_size)
+{
+    basic_optimized_vector<16> v;
+    for (uint32_t i = 0; i < 16; ++i)
+        v.push_back(i);
+    basic_optimized_vector<16> w(v);
+    for (uint32_t i = 0; i < 16; ++i)
+        ASSERT_EQ(w[i], i);
+    w.push_back(16);
+    ASSERT_EQ(w.size(), 17u);
+    ASSERT_EQ(w.back(), 16u);
+    ASSERT_EQ(v.size(), 16u);
+}
+
+TEST(vector, no_thrashing_near_small_size)
+{
+    basic_optimized_vector<8> v(9, VAL);
+    const uint32_t* heap_data = v.cbegin();
+    for (size_t i = 0; i < 10; ++i)
+    {
+        v.pop_back();
+        v.resize(7);
+        v.push_back(VAL);
+        v.resize(9);
+        ASSERT_EQ(v.cbegin(), heap_data);
+    }
+    ASSERT_EQ(v[0], VAL);
+
+    v.resize(4);
+    ASSERT_NE(v.cbegin(), heap_data);
+    ASSERT_EQ(v[3], VAL);
+}
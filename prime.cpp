@@ -0,0 +1,397 @@
+#include "prime.h"
+#include "modular.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // trial division covers the primes below this bound, which settles every n below its square
+    const uint32_t TRIAL_LIMIT = 1000;
+    // interval sieves remove the multiples of the primes below this bound
+    const uint32_t SIEVE_LIMIT = 1u << 15;
+    // odd candidates sieved at a time
+    const size_t SIEVE_WINDOW = 1u << 16;
+
+    // primes below limit (sieve of Eratosthenes)
+    std::vector<uint32_t> sieve_primes(uint32_t limit)
+    {
+        std::vector<bool> composite(limit, false);
+        std::vector<uint32_t> primes;
+        for (uint32_t i = 2; i < limit; ++i)
+        {
+            if (composite[i])
+                continue;
+            primes.push_back(i);
+            for (uint64_t j = static_cast<uint64_t>(i) * i; j < limit; j += i)
+                composite[j] = true;
+        }
+        return primes;
+    }
+
+    // consecutive runs of the trial primes whose products fit in a limb, so that one remainder of n
+    // serves the whole run
+    struct trial_group
+    {
+        uint32_t product;
+        size_t end;
+    };
+
+    struct trial_table
+    {
+        std::vector<uint32_t> primes;
+        std::vector<trial_group> groups;
+
+        explicit trial_table(uint32_t limit) : primes(sieve_primes(limit))
+        {
+            uint32_t product = 1;
+            for (size_t i = 0; i != primes.size(); ++i)
+            {
+                if (product > UINT32_MAX / primes[i])
+                {
+                    groups.push_back({product, i});
+                    product = 1;
+                }
+                product *= primes[i];
+            }
+            groups.push_back({product, primes.size()});
+        }
+    };
+
+    enum trial_result
+    {
+        COMPOSITE,
+        PRIME,
+        UNKNOWN
+    };
+
+    trial_result trial_division(big_integer const& n)
+    {
+        static const trial_table table(TRIAL_LIMIT);
+        if (n < TRIAL_LIMIT)
+            return std::binary_search(table.primes.begin(), table.primes.end(), n.to_uint64()) ? PRIME : COMPOSITE;
+
+        size_t first = 0;
+        for (trial_group const& group : table.groups)
+        {
+            auto r = static_cast<uint32_t>((n % group.product).to_uint64());
+            for (size_t i = first; i != group.end; ++i)
+                if (r % table.primes[i] == 0)
+                    return COMPOSITE;
+            first = group.end;
+        }
+        return n < TRIAL_LIMIT * TRIAL_LIMIT ? PRIME : UNKNOWN;
+    }
+
+    bool is_zero_span(const uint32_t* a, size_t n)
+    {
+        return std::all_of(a, a + n, [](uint32_t x) { return x == 0; });
+    }
+
+    // one Miller-Rabin round for odd n > 3 and a base in [2, n - 2]: with n - 1 = d * 2^s, base^d is
+    // 1 or reaches -1 within s - 1 squarings when n is prime
+    bool miller_rabin(montgomery_context const& ctx, big_integer const& n, big_integer const& base)
+    {
+        big_integer n_minus_1 = n - 1;
+        size_t s = n_minus_1.count_trailing_zeros();
+        big_integer d = n_minus_1 >> static_cast<int>(s);
+
+        size_t k = ctx.size();
+        limb_vector buffers;
+        buffers.resize_uninitialized(5 * k);
+        uint32_t* x = buffers.mutable_data();
+        uint32_t* one = x + k;
+        uint32_t* minus_one = one + k;
+        uint32_t* scratch = minus_one + k;
+        ctx.to_montgomery(x, ctx.powmod(base, d));
+        ctx.to_montgomery(one, 1);
+        ctx.to_montgomery(minus_one, n_minus_1);
+
+        if (std::equal(x, x + k, one) || std::equal(x, x + k, minus_one))
+            return true;
+        for (size_t i = 1; i < s; ++i)
+        {
+            ctx.sqr(x, x, scratch);
+            if (std::equal(x, x + k, minus_one))
+                return true;
+            if (std::equal(x, x + k, one))
+                return false;
+        }
+        return false;
+    }
+
+    // Strong Lucas test with Selfridge's parameters: P = 1 and Q = (1 - D) / 4 for the first D of
+    // 5, -7, 9, -11, ... with (D / n) = -1, for odd n > 1 that is not a square. With n + 1 = d * 2^s,
+    // a prime n has U_d = 0 or V_(d * 2^r) = 0 for some r < s. Only V is computed, by a ladder over
+    // (V_k, V_(k+1), Q^k), as D * U_d = 2 * V_(d+1) - V_d.
+    bool strong_lucas(montgomery_context const& ctx, big_integer const& n)
+    {
+        int64_t discriminant = 5;
+        while (true)
+        {
+            int j = jacobi(discriminant, n);
+            if (j == -1)
+                break;
+            // D = +-n only shares the factor n itself, which is then prime as no smaller D did
+            if (j == 0)
+                return n == (discriminant < 0 ? -discriminant : discriminant);
+            discriminant = discriminant > 0 ? -(discriminant + 2) : -discriminant + 2;
+        }
+
+        big_integer d = n + 1;
+        size_t s = d.count_trailing_zeros();
+        d >>= static_cast<int>(s);
+
+        size_t k = ctx.size();
+        limb_vector buffers;
+        buffers.resize_uninitialized(8 * k);
+        uint32_t* v = buffers.mutable_data();
+        uint32_t* w = v + k;
+        uint32_t* qk = w + k;
+        uint32_t* q = qk + k;
+        uint32_t* t = q + k;
+        uint32_t* u = t + k;
+        uint32_t* scratch = u + k;
+        ctx.to_montgomery(v, 2);
+        ctx.to_montgomery(w, 1);
+        ctx.to_montgomery(qk, 1);
+        ctx.to_montgomery(q, (1 - discriminant) / 4);
+
+        for (size_t i = d.bit_length(); i-- > 0;)
+        {
+            // V_(2k+1) = V_k * V_(k+1) - Q^k
+            ctx.mul(t, v, w, scratch);
+            ctx.sub(t, t, qk);
+            if (d.test_bit(i))
+            {
+                // V_(2k+2) = V_(k+1)^2 - 2 * Q^(k+1), Q^(2k+1) = Q^k * Q^(k+1)
+                ctx.mul(u, qk, q, scratch);
+                ctx.sqr(w, w, scratch);
+                ctx.sub(w, w, u);
+                ctx.sub(w, w, u);
+                ctx.mul(qk, qk, u, scratch);
+                std::copy(t, t + k, v);
+            }
+            else
+            {
+                // V_(2k) = V_k^2 - 2 * Q^k, Q^(2k) = (Q^k)^2
+                ctx.sqr(v, v, scratch);
+                ctx.sub(v, v, qk);
+                ctx.sub(v, v, qk);
+                ctx.sqr(qk, qk, scratch);
+                std::copy(t, t + k, w);
+            }
+        }
+
+        ctx.add(t, w, w);
+        ctx.sub(t, t, v);
+        if (is_zero_span(t, k) || is_zero_span(v, k))
+            return true;
+        for (size_t r = 1; r < s; ++r)
+        {
+            ctx.sqr(v, v, scratch);
+            ctx.sub(v, v, qk);
+            ctx.sub(v, v, qk);
+            if (is_zero_span(v, k))
+                return true;
+            ctx.sqr(qk, qk, scratch);
+        }
+        return false;
+    }
+
+    // (a / n) for odd n, a < n, both words
+    int jacobi_word(uint64_t a, uint64_t n, int result)
+    {
+        while (a != 0)
+        {
+            int zeros = __builtin_ctzll(a);
+            a >>= zeros;
+            if ((zeros & 1) && (n % 8 == 3 || n % 8 == 5))
+                result = -result;
+            if (a % 4 == 3 && n % 4 == 3)
+                result = -result;
+            uint64_t r = n % a;
+            n = a;
+            a = r;
+        }
+        return n == 1 ? result : 0;
+    }
+
+    // Baillie-PSW and the extra Miller-Rabin rounds of is_probable_prime, for odd n > 10^6
+    bool passes_bpsw(big_integer const& n, unsigned rounds)
+    {
+        montgomery_context ctx(n);
+        if (!miller_rabin(ctx, n, 2) || is_perfect_square(n) || !strong_lucas(ctx, n))
+            return false;
+
+        std::mt19937_64 generator(n.to_uint64());
+        big_integer range = n - 3;
+        for (unsigned i = 0; i != rounds; ++i)
+        {
+            // a little wider than n, so the reduction into [2, n - 2] is close to uniform
+            big_integer base = 0;
+            for (size_t bits = 0; bits < n.bit_length() + 64; bits += 64)
+                base = (base << 64) + generator();
+            if (!miller_rabin(ctx, n, base % range + 2))
+                return false;
+        }
+        return true;
+    }
+
+    // start mod p for every prime of the table, with one multi-limb remainder per group
+    std::vector<uint32_t> residues(trial_table const& table, big_integer const& start)
+    {
+        std::vector<uint32_t> result(table.primes.size());
+        size_t first = 0;
+        for (trial_group const& group : table.groups)
+        {
+            auto r = static_cast<uint32_t>((start % group.product).to_uint64());
+            for (size_t i = first; i != group.end; ++i)
+                result[i] = r % table.primes[i];
+            first = group.end;
+        }
+        return result;
+    }
+
+    // Appends the probable primes among the odd values start, start + 2, ..., start + 2 * (count - 1),
+    // for odd start, until result holds limit values. Multiples of the primes below SIEVE_LIMIT are
+    // crossed out first from the residues of start; survivors below SIEVE_LIMIT^2 are primes, the rest
+    // go through Baillie-PSW without repeating trial division.
+    void append_primes(std::vector<big_integer>& result, big_integer const& start, size_t count,
+                       unsigned rounds, size_t limit)
+    {
+        static const trial_table table(SIEVE_LIMIT);
+        std::vector<uint32_t> r = residues(table, start);
+        std::vector<bool> survivor(count, true);
+        bool small_start = start < SIEVE_LIMIT;
+        for (size_t i = 1; i != table.primes.size(); ++i)
+        {
+            // start + 2j is a multiple of p for j = -start / 2 mod p; p itself is not crossed out
+            uint32_t p = table.primes[i];
+            uint64_t j = r[i] == 0 ? 0 : static_cast<uint64_t>(p - r[i]) * ((p + 1) / 2) % p;
+            if (small_start && start + 2 * j == p)
+                j += p;
+            for (; j < count; j += p)
+                survivor[j] = false;
+        }
+
+        uint64_t proven_bound = static_cast<uint64_t>(SIEVE_LIMIT) * SIEVE_LIMIT;
+        for (size_t j = 0; j != count && result.size() < limit; ++j)
+        {
+            if (!survivor[j])
+                continue;
+            big_integer candidate = start + 2 * j;
+            if (candidate == 1)
+                continue;
+            if (candidate < proven_bound || passes_bpsw(candidate, rounds))
+                result.push_back(candidate);
+        }
+    }
+}
+
+int jacobi(big_integer const& a, big_integer const& n)
+{
+    big_integer x = a % n, y = n;
+    if (x.sgn() < 0)
+        x += n;
+
+    // (x / y) = (y mod x / x) up to sign for odd x, y, with the factors of two taken out of x first
+    int result = 1;
+    while (!y.fits_uint64())
+    {
+        if (x.is_zero())
+            return 0;
+        size_t zeros = x.count_trailing_zeros();
+        x >>= static_cast<int>(zeros);
+        uint64_t y_low = y.to_uint64();
+        if ((zeros & 1) && (y_low % 8 == 3 || y_low % 8 == 5))
+            result = -result;
+        if (x.to_uint64() % 4 == 3 && y_low % 4 == 3)
+            result = -result;
+        big_integer r = y % x;
+        y = x;
+        x = r;
+    }
+    return jacobi_word(x.to_uint64(), y.to_uint64(), result);
+}
+
+bool is_probable_prime(big_integer const& n, unsigned rounds)
+{
+    if (n < 2)
+        return false;
+    switch (trial_division(n))
+    {
+    case COMPOSITE:
+        return false;
+    case PRIME:
+        return true;
+    case UNKNOWN:
+        break;
+    }
+
+    return passes_bpsw(n, rounds);
+}
+
+bool is_strong_probable_prime(big_integer const& n, big_integer const& base)
+{
+    return miller_rabin(montgomery_context(n), n, base);
+}
+
+bool is_strong_lucas_probable_prime(big_integer const& n)
+{
+    return !is_perfect_square(n) && strong_lucas(montgomery_context(n), n);
+}
+
+std::vector<big_integer> primes_between(big_integer const& low, big_integer const& high, unsigned rounds)
+{
+    std::vector<big_integer> result;
+    big_integer start = low;
+    if (start <= 2)
+    {
+        if (high > 2)
+            result.push_back(2);
+        start = 3;
+    }
+    if (!start.test_bit(0))
+        start += 1;
+    while (start < high)
+    {
+        big_integer remaining = (high - start + 1) / 2;
+        size_t count = remaining < SIEVE_WINDOW ? remaining.to_uint64() : SIEVE_WINDOW;
+        append_primes(result, start, count, rounds, SIZE_MAX);
+        start += 2 * count;
+    }
+    return result;
+}
+
+std::vector<big_integer> next_primes(big_integer const& n, size_t count, unsigned rounds)
+{
+    std::vector<big_integer> result;
+    if (count == 0)
+        return result;
+    big_integer start = n + 1;
+    if (start <= 2)
+    {
+        result.push_back(2);
+        start = 3;
+    }
+    if (!start.test_bit(0))
+        start += 1;
+
+    // about three times the expected number of odd candidates per prime, (ln n) / 2
+    size_t window = std::min(SIEVE_WINDOW, std::max<size_t>(64, count * start.bit_length()));
+    while (result.size() < count)
+    {
+        append_primes(result, start, window, rounds, count);
+        start += 2 * window;
+    }
+    return result;
+}
+
+big_integer next_prime(big_integer const& n)
+{
+    return next_primes(n, 1)[0];
+}
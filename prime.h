@@ -0,0 +1,30 @@
+#ifndef PRIME_H
+#define PRIME_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <vector>
+
+// Jacobi symbol (a / n) for odd n > 0: 0 when gcd(a, n) != 1, otherwise +1 or -1
+int jacobi(big_integer const& a, big_integer const& n);
+
+// Whether n is a probable prime. Trial division by the primes below 1000 settles every n below 10^6 and
+// rejects most composites; the rest get the Baillie-PSW test, a Miller-Rabin round to base 2 followed by a
+// strong Lucas test, with no known composite passing both. rounds adds Miller-Rabin rounds to bases
+// drawn from a generator seeded by n, so the answer for a given n is always the same.
+bool is_probable_prime(big_integer const& n, unsigned rounds = 0);
+
+// The halves of Baillie-PSW on their own, without trial division, for odd n > 3: a Miller-Rabin round to
+// a base in [2, n - 2], and the strong Lucas test with Selfridge's parameters (false for squares)
+bool is_strong_probable_prime(big_integer const& n, big_integer const& base);
+bool is_strong_lucas_probable_prime(big_integer const& n);
+
+// the smallest probable prime above n
+big_integer next_prime(big_integer const& n);
+// the count smallest probable primes above n, in increasing order
+std::vector<big_integer> next_primes(big_integer const& n, size_t count, unsigned rounds = 0);
+// the probable primes in [low, high), in increasing order
+std::vector<big_integer> primes_between(big_integer const& low, big_integer const& high, unsigned rounds = 0);
+
+#endif // PRIME_H
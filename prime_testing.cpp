@@ -0,0 +1,239 @@
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "prime.h"
+
+namespace
+{
+    big_integer rand_big(size_t size)
+    {
+        big_integer result = rand();
+
+        for (size_t i = 0; i != size; ++i)
+        {
+            result *= RAND_MAX;
+            result += rand();
+        }
+
+        return result;
+    }
+
+    std::vector<bool> sieve(size_t limit)
+    {
+        std::vector<bool> prime(limit, true);
+        prime[0] = prime[1] = false;
+        for (size_t i = 2; i * i < limit; ++i)
+            if (prime[i])
+                for (size_t j = i * i; j < limit; j += i)
+                    prime[j] = false;
+        return prime;
+    }
+
+    int naive_jacobi(int64_t a, int64_t n)
+    {
+        // Euler's criterion for prime n, multiplied over the factorization otherwise
+        int result = 1;
+        a = ((a % n) + n) % n;
+        for (int64_t p = 3; n > 1; p += 2)
+        {
+            while (n % p == 0)
+            {
+                n /= p;
+                int64_t power = 1;
+                for (int64_t e = 0; e < (p - 1) / 2; ++e)
+                    power = power * a % p;
+                result *= power == 0 ? 0 : (power == 1 ? 1 : -1);
+            }
+        }
+        return result;
+    }
+}
+
+TEST(prime, jacobi)
+{
+    EXPECT_EQ(jacobi(2, 7), 1);
+    EXPECT_EQ(jacobi(3, 7), -1);
+    EXPECT_EQ(jacobi(0, 1), 1);
+    EXPECT_EQ(jacobi(6, 9), 0);
+    EXPECT_EQ(jacobi(-1, 11), -1);
+    for (int64_t n = 1; n < 300; n += 2)
+        for (int64_t a = -40; a < 340; a += 7)
+            ASSERT_EQ(jacobi(a, n), naive_jacobi(a, n)) << a << " " << n;
+
+    // multiplicative in a, and the same across the big/word boundary
+    big_integer p("170141183460469231731687303715884105727");
+    for (size_t itn = 0; itn != 100; ++itn)
+    {
+        big_integer a = rand_big(rand() % 8), b = rand_big(rand() % 8);
+        ASSERT_EQ(jacobi(a * b, p), jacobi(a, p) * jacobi(b, p));
+    }
+}
+
+TEST(prime, small)
+{
+    // trial division alone settles everything below 10^6, the rest of the range goes through BPSW
+    std::vector<bool> prime = sieve(1100000);
+    for (size_t i = 0; i != prime.size(); ++i)
+        ASSERT_EQ(is_probable_prime(i), prime[i]) << i;
+    EXPECT_FALSE(is_probable_prime(-7));
+}
+
+TEST(prime, pseudoprimes)
+{
+    // Carmichael numbers, strong pseudoprimes to base 2 and strong Lucas pseudoprimes that trial division
+    // already rejects
+    for (const char* n : {"561", "41041", "825265", "321197185", "2047", "3277", "4033", "3215031751", "5459",
+                          "5777", "10877", "16109", "18971", "22499", "24569", "25199", "40309", "58519"})
+        EXPECT_FALSE(is_probable_prime(big_integer(n))) << n;
+
+    // strong pseudoprimes to base 2 without a factor below 1000 (to every base up to 23, and up to 37):
+    // with no extra rounds, only the Lucas half can reject them
+    for (const char* n : {"3825123056546413051", "318665857834031151167461"})
+    {
+        EXPECT_TRUE(is_strong_probable_prime(big_integer(n), 2)) << n;
+        EXPECT_FALSE(is_strong_lucas_probable_prime(big_integer(n))) << n;
+        EXPECT_FALSE(is_probable_prime(big_integer(n))) << n;
+    }
+
+    // strong Lucas pseudoprimes with both factors above 1000, left to the Miller-Rabin half
+    for (const char* n : {"1711469", "2263127", "3813011"})
+    {
+        EXPECT_TRUE(is_strong_lucas_probable_prime(big_integer(n))) << n;
+        EXPECT_FALSE(is_strong_probable_prime(big_integer(n), 2)) << n;
+        EXPECT_FALSE(is_probable_prime(big_integer(n))) << n;
+    }
+
+    // each half on its own accepts primes
+    for (const char* n : {"1000003", "2305843009213693951", "170141183460469231731687303715884105727"})
+    {
+        EXPECT_TRUE(is_strong_probable_prime(big_integer(n), 2)) << n;
+        EXPECT_TRUE(is_strong_probable_prime(big_integer(n), 12345)) << n;
+        EXPECT_TRUE(is_strong_lucas_probable_prime(big_integer(n))) << n;
+    }
+    // including the small primes that the search for D reaches as D = +-n
+    for (int n : {5, 7, 11, 13, 17, 19, 23})
+    {
+        EXPECT_TRUE(is_strong_probable_prime(n, 2)) << n;
+        EXPECT_TRUE(is_strong_lucas_probable_prime(n)) << n;
+    }
+
+    // squares of the Wieferich primes pass Miller-Rabin to base 2, and a square would stall the search
+    // for D in the Lucas test
+    EXPECT_FALSE(is_probable_prime(1093 * 1093));
+    EXPECT_FALSE(is_probable_prime(3511 * 3511));
+    EXPECT_TRUE(is_strong_probable_prime(1093 * 1093, 2));
+    EXPECT_FALSE(is_strong_lucas_probable_prime(1093 * 1093));
+}
+
+TEST(prime, large)
+{
+    for (size_t bits : {61u, 89u, 107u, 127u, 521u, 607u, 1279u})
+        EXPECT_TRUE(is_probable_prime((big_integer(1) << bits) - 1, 3)) << bits;
+    for (size_t bits : {67u, 101u, 257u})
+        EXPECT_FALSE(is_probable_prime((big_integer(1) << bits) - 1)) << bits;
+
+    big_integer p("170141183460469231731687303715884105727");
+    big_integer q = (big_integer(1) << 89) - 1;
+    EXPECT_FALSE(is_probable_prime(p * q, 3));
+    EXPECT_FALSE(is_probable_prime(p * p, 3));
+
+    for (size_t itn = 0; itn != 20; ++itn)
+    {
+        big_integer a = next_prime(rand_big(rand() % 12 + 1)), b = next_prime(rand_big(rand() % 12 + 1));
+        ASSERT_TRUE(is_probable_prime(a, 5));
+        ASSERT_FALSE(is_probable_prime(a * b, 5));
+    }
+}
+
+TEST(prime, next_prime)
+{
+    EXPECT_EQ(next_prime(-5), 2);
+    EXPECT_EQ(next_prime(0), 2);
+    EXPECT_EQ(next_prime(2), 3);
+    EXPECT_EQ(next_prime(7), 11);
+    EXPECT_EQ(next_prime(999983), 1000003);
+    EXPECT_EQ(next_prime(big_integer(1) << 64), (big_integer(1) << 64) + 13);
+    EXPECT_EQ(next_prime((big_integer(1) << 127) - 2), (big_integer(1) << 127) - 1);
+    big_integer googol = pow(big_integer(10), 100);
+    EXPECT_EQ(next_prime(googol), googol + 267);
+
+    std::vector<bool> prime = sieve(20000);
+    for (size_t itn = 0; itn != 200; ++itn)
+    {
+        size_t n = rand() % 19000;
+        size_t expected = n + 1;
+        while (!prime[expected])
+            ++expected;
+        ASSERT_EQ(next_prime(n), expected);
+    }
+}
+
+TEST(prime, primes_between)
+{
+    // the small primes of the sieve itself must survive it, so start from the bottom
+    std::vector<bool> prime = sieve(300000);
+    std::vector<big_integer> expected;
+    for (size_t i = 0; i != prime.size(); ++i)
+        if (prime[i])
+            expected.push_back(i);
+    EXPECT_EQ(primes_between(0, 300000), expected);
+    EXPECT_EQ(primes_between(-10, 3), std::vector<big_integer>({2}));
+    EXPECT_TRUE(primes_between(24, 29).empty());
+    EXPECT_TRUE(primes_between(100, 50).empty());
+
+    for (size_t itn = 0; itn != 200; ++itn)
+    {
+        size_t low = rand() % 290000, high = low + rand() % 5000;
+        std::vector<big_integer> result = primes_between(low, high);
+        size_t k = 0;
+        for (size_t i = low; i < high && i < prime.size(); ++i)
+        {
+            if (prime[i])
+            {
+                ASSERT_EQ(result.at(k++), i) << low << " " << high;
+            }
+        }
+        ASSERT_EQ(result.size(), k) << low << " " << high;
+    }
+
+    // beyond the square of the sieve bound, survivors go through BPSW; compare with testing every value
+    for (size_t itn = 0; itn != 10; ++itn)
+    {
+        big_integer low = rand_big(rand() % 8 + 2);
+        big_integer high = low + 3000;
+        std::vector<big_integer> result = primes_between(low, high);
+        size_t k = 0;
+        for (big_integer i = low; i < high; i += 1)
+        {
+            if (is_probable_prime(i))
+            {
+                ASSERT_EQ(result.at(k++), i);
+            }
+        }
+        ASSERT_EQ(result.size(), k);
+    }
+}
+
+TEST(prime, next_primes)
+{
+    EXPECT_TRUE(next_primes(10, 0).empty());
+    EXPECT_EQ(next_primes(-3, 5), std::vector<big_integer>({2, 3, 5, 7, 11}));
+    EXPECT_EQ(next_primes(32749, 3), std::vector<big_integer>({32771, 32779, 32783}));
+
+    // crosses several sieve windows
+    std::vector<big_integer> expected = primes_between(1000000, 2000000);
+    EXPECT_EQ(next_primes(999999, expected.size()), expected);
+
+    // the sieve must not skip any prime that a plain scan finds
+    big_integer n = (big_integer(1) << 512) + 1;
+    std::vector<big_integer> result = next_primes(n - 1, 8, 2);
+    ASSERT_EQ(result.size(), 8u);
+    for (big_integer const& p : result)
+    {
+        while (!is_probable_prime(n))
+            n += 2;
+        EXPECT_EQ(p, n);
+        n += 2;
+    }
+}